@@ -513,6 +513,26 @@ gpk_time_ago_to_localised_string (guint seconds_ago)
 		                        years_ago);
 }
 
+/**
+ * gpk_download_rate_update:
+ * @rate: The current estimate in bytes per second, or 0 when unknown
+ * @sample: The rate observed now in bytes per second
+ *
+ * Keeps a moving average of the download rate, so one slow or fast
+ * mirror does not change the estimate at once.
+ *
+ * Returns: the new estimate in bytes per second
+ **/
+guint
+gpk_download_rate_update (guint rate, guint sample)
+{
+	if (sample == 0)
+		return rate;
+	if (rate == 0)
+		return sample;
+	return (guint) (((guint64) rate * 7 + sample) / 8);
+}
+
 /**
  * gpk_strv_join_locale:
  *
@@ -48,6 +48,13 @@ G_BEGIN_DECLS
 #define GPK_SETTINGS_FREQUENCY_REFRESH_CACHE		"frequency-refresh-cache"
 #define GPK_SETTINGS_FREQUENCY_UPDATES_NOTIFICATION	"frequency-updates-notification"
 #define GPK_SETTINGS_LAST_UPDATES_NOTIFICATION		"last-updates-notification"
+#define GPK_SETTINGS_BACKGROUND_REFRESH			"background-refresh"
+#define GPK_SETTINGS_DOWNLOAD_RATE			"download-rate"
+#define GPK_SETTINGS_MAX_BUSY_DEFERRAL		"max-busy-deferral"
+
+#define GPK_UPDATES_DBUS_NAME				"org.xings.SoftwareService"
+#define GPK_UPDATES_DBUS_PATH				"/org/xings/SoftwareService"
+#define GPK_UPDATES_DBUS_INTERFACE			"org.xings.SoftwareService.Updates"
 
 #define GPK_ICON_SOFTWARE_INSTALLER			"system-software-installer"
 #define GPK_ICON_SOFTWARE_UPDATE			"system-software-update"
@@ -60,6 +67,10 @@ G_BEGIN_DECLS
 /* any status that is slower than this will not be shown in the UI */
 #define GPK_UI_STATUS_SHOW_DELAY		750 /* ms */
 
+/* the search is started when the user stops typing */
+#define GPK_UI_SEARCH_TYPEAHEAD_DELAY		300 /* ms */
+#define GPK_UI_SEARCH_TYPEAHEAD_MIN_LENGTH	2
+
 gchar		*gpk_package_id_get_name		(const gchar    *package_id);
 
 gchar		*gpk_common_format_details		(const gchar   *summary,
@@ -73,6 +84,8 @@ gchar		*gpk_package_id_format_oneline		(const gchar 	*package_id,
 gchar		*gpk_package_id_format_pretty		(const gchar	*package_id);
 gchar		*gpk_time_to_imprecise_string		(guint		 time_secs);
 gchar		*gpk_time_ago_to_localised_string	(guint		 seconds_ago);
+guint		 gpk_download_rate_update		(guint		 rate,
+							 guint		 sample);
 
 gboolean	 gpk_check_privileged_user		(const gchar	*application_name,
 							 gboolean	 show_ui);
@@ -0,0 +1,246 @@
+/* -*- Mode: C; tab-width: 8; indent-tabs-mode: t; c-basic-offset: 8 -*-
+ *
+ * Copyright (C) 2022 Matias De lellis <matias@delellis.com.ar>
+ *
+ * Licensed under the GNU General Public License Version 2
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "config.h"
+
+#include <errno.h>
+#include <glib.h>
+#include <glib/gstdio.h>
+
+#include "gpk-update-snapshot.h"
+
+#define GPK_UPDATE_SNAPSHOT_VERSION	1
+#define GPK_UPDATE_SNAPSHOT_TYPE	"(uxa" GPK_UPDATE_SNAPSHOT_RECORD ")"
+
+static gchar *
+gpk_update_snapshot_get_filename (void)
+{
+	return g_build_filename (g_get_user_cache_dir (),
+	                         "xings-software",
+	                         "updates.gvariant",
+	                         NULL);
+}
+
+/**
+ * gpk_update_snapshot_item_new:
+ **/
+GpkUpdateSnapshotItem *
+gpk_update_snapshot_item_new (const gchar *package_id, PkInfoEnum info, const gchar *summary)
+{
+	GpkUpdateSnapshotItem *item;
+
+	item = g_new0 (GpkUpdateSnapshotItem, 1);
+	item->package_id = g_strdup (package_id);
+	item->info = info;
+	item->summary = g_strdup (summary);
+	item->restart = PK_RESTART_ENUM_NONE;
+
+	return item;
+}
+
+/**
+ * gpk_update_snapshot_item_free:
+ **/
+void
+gpk_update_snapshot_item_free (GpkUpdateSnapshotItem *item)
+{
+	if (item == NULL)
+		return;
+	g_free (item->package_id);
+	g_free (item->summary);
+	g_free (item->update_text);
+	g_free (item);
+}
+
+/**
+ * gpk_update_snapshot_to_variant:
+ *
+ * Returns a floating array of records, as saved and as shared on the bus.
+ **/
+GVariant *
+gpk_update_snapshot_to_variant (GPtrArray *items)
+{
+	GVariantBuilder builder;
+	GpkUpdateSnapshotItem *item = NULL;
+	guint i;
+
+	g_variant_builder_init (&builder, G_VARIANT_TYPE ("a" GPK_UPDATE_SNAPSHOT_RECORD));
+	for (i = 0; items != NULL && i < items->len; i++) {
+		item = g_ptr_array_index (items, i);
+		g_variant_builder_add (&builder, GPK_UPDATE_SNAPSHOT_RECORD,
+		                       item->package_id,
+		                       (guint32) item->info,
+		                       item->summary != NULL ? item->summary : "",
+		                       (gint64) item->size,
+		                       (guint32) item->restart,
+		                       item->update_text != NULL ? item->update_text : "");
+	}
+
+	return g_variant_builder_end (&builder);
+}
+
+/**
+ * gpk_update_snapshot_from_variant:
+ **/
+GPtrArray *
+gpk_update_snapshot_from_variant (GVariant *records)
+{
+	GVariantIter iter;
+	GPtrArray *items = NULL;
+	GpkUpdateSnapshotItem *item = NULL;
+	const gchar *package_id = NULL, *summary = NULL, *update_text = NULL;
+	guint32 info = 0, restart = 0;
+	gint64 size = 0;
+
+	items = g_ptr_array_new_with_free_func ((GDestroyNotify) gpk_update_snapshot_item_free);
+
+	g_variant_iter_init (&iter, records);
+	while (g_variant_iter_next (&iter, "(&su&sxu&s)",
+	                            &package_id, &info, &summary, &size, &restart, &update_text)) {
+		item = gpk_update_snapshot_item_new (package_id, info, summary);
+		item->size = (guint64) size;
+		item->restart = restart;
+		if (update_text[0] != '\0')
+			item->update_text = g_strdup (update_text);
+		g_ptr_array_add (items, item);
+	}
+
+	return items;
+}
+
+/**
+ * gpk_update_snapshot_load:
+ *
+ * Loads the last known list of updates, with the details that were known
+ * when it was saved, so it can be shown before PackageKit answers.
+ **/
+GPtrArray *
+gpk_update_snapshot_load (gint64 *timestamp, GError **error)
+{
+	GMappedFile *mapped = NULL;
+	GBytes *bytes = NULL;
+	GVariant *snapshot = NULL, *records = NULL;
+	GPtrArray *items = NULL;
+	gchar *filename = NULL;
+	guint32 version = 0;
+
+	filename = gpk_update_snapshot_get_filename ();
+	mapped = g_mapped_file_new (filename, FALSE, error);
+	if (mapped == NULL)
+		goto out;
+
+	bytes = g_mapped_file_get_bytes (mapped);
+	snapshot = g_variant_ref_sink (g_variant_new_from_bytes (G_VARIANT_TYPE (GPK_UPDATE_SNAPSHOT_TYPE), bytes, FALSE));
+
+	g_variant_get_child (snapshot, 0, "u", &version);
+	if (version != GPK_UPDATE_SNAPSHOT_VERSION) {
+		g_set_error (error, G_FILE_ERROR, G_FILE_ERROR_INVAL,
+		             "Unsupported update snapshot version %u", version);
+		goto out;
+	}
+	if (timestamp != NULL)
+		g_variant_get_child (snapshot, 1, "x", timestamp);
+
+	records = g_variant_get_child_value (snapshot, 2);
+	items = gpk_update_snapshot_from_variant (records);
+
+out:
+	if (records != NULL)
+		g_variant_unref (records);
+	if (snapshot != NULL)
+		g_variant_unref (snapshot);
+	if (bytes != NULL)
+		g_bytes_unref (bytes);
+	if (mapped != NULL)
+		g_mapped_file_unref (mapped);
+	g_free (filename);
+
+	return items;
+}
+
+/**
+ * gpk_update_snapshot_load_index:
+ *
+ * Loads the last snapshot indexed by package id, it is always returned,
+ * even empty, so it can be used to keep the known details of the packages.
+ **/
+GHashTable *
+gpk_update_snapshot_load_index (void)
+{
+	GHashTable *index = NULL;
+	GPtrArray *items = NULL;
+	GpkUpdateSnapshotItem *item = NULL;
+	guint i;
+
+	index = g_hash_table_new_full (g_str_hash, g_str_equal,
+	                               NULL, (GDestroyNotify) gpk_update_snapshot_item_free);
+
+	items = gpk_update_snapshot_load (NULL, NULL);
+	if (items == NULL)
+		return index;
+
+	/* the index now owns the items */
+	g_ptr_array_set_free_func (items, NULL);
+	for (i = 0; i < items->len; i++) {
+		item = g_ptr_array_index (items, i);
+		g_hash_table_replace (index, item->package_id, item);
+	}
+	g_ptr_array_unref (items);
+
+	return index;
+}
+
+/**
+ * gpk_update_snapshot_save:
+ **/
+gboolean
+gpk_update_snapshot_save (GPtrArray *items, GError **error)
+{
+	GVariant *snapshot = NULL;
+	gchar *filename = NULL, *dirname = NULL;
+	gboolean ret = FALSE;
+
+	snapshot = g_variant_ref_sink (g_variant_new ("(ux@a" GPK_UPDATE_SNAPSHOT_RECORD ")",
+	                                              GPK_UPDATE_SNAPSHOT_VERSION,
+	                                              g_get_real_time () / G_USEC_PER_SEC,
+	                                              gpk_update_snapshot_to_variant (items)));
+
+	filename = gpk_update_snapshot_get_filename ();
+	dirname = g_path_get_dirname (filename);
+	if (g_mkdir_with_parents (dirname, 0700) != 0) {
+		g_set_error (error, G_FILE_ERROR,
+		             g_file_error_from_errno (errno),
+		             "Failed to create %s", dirname);
+		goto out;
+	}
+
+	ret = g_file_set_contents (filename,
+	                           g_variant_get_data (snapshot),
+	                           (gssize) g_variant_get_size (snapshot),
+	                           error);
+
+out:
+	g_variant_unref (snapshot);
+	g_free (dirname);
+	g_free (filename);
+
+	return ret;
+}
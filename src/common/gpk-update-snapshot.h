@@ -0,0 +1,58 @@
+/* -*- Mode: C; tab-width: 8; indent-tabs-mode: t; c-basic-offset: 8 -*-
+ *
+ * Copyright (C) 2022 Matias De lellis <matias@delellis.com.ar>
+ *
+ * Licensed under the GNU General Public License Version 2
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef __GPK_UPDATE_SNAPSHOT_H
+#define __GPK_UPDATE_SNAPSHOT_H
+
+#include <glib.h>
+#include <packagekit-glib2/packagekit.h>
+
+G_BEGIN_DECLS
+
+/* package-id, info, summary, size, restart, update-text */
+#define GPK_UPDATE_SNAPSHOT_RECORD	"(susxus)"
+
+typedef struct {
+	gchar		*package_id;
+	PkInfoEnum	 info;
+	gchar		*summary;
+	guint64		 size;
+	PkRestartEnum	 restart;
+	gchar		*update_text;
+} GpkUpdateSnapshotItem;
+
+GpkUpdateSnapshotItem	*gpk_update_snapshot_item_new	(const gchar	*package_id,
+							 PkInfoEnum	 info,
+							 const gchar	*summary);
+void		 gpk_update_snapshot_item_free		(GpkUpdateSnapshotItem *item);
+
+GVariant	*gpk_update_snapshot_to_variant		(GPtrArray	*items);
+GPtrArray	*gpk_update_snapshot_from_variant	(GVariant	*records);
+
+GPtrArray	*gpk_update_snapshot_load		(gint64		*timestamp,
+							 GError		**error);
+GHashTable	*gpk_update_snapshot_load_index		(void);
+gboolean	 gpk_update_snapshot_save		(GPtrArray	*items,
+							 GError		**error);
+
+G_END_DECLS
+
+#endif	/* __GPK_UPDATE_SNAPSHOT_H */
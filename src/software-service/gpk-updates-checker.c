@@ -22,6 +22,7 @@
 #include <glib/gi18n.h>
 
 #include <common/gpk-common.h>
+#include <common/gpk-update-snapshot.h>
 
 #include "gpk-updates-shared.h"
 
@@ -32,12 +33,20 @@ struct _GpkUpdatesChecker
 	GObject			_parent;
 
 	GPtrArray		*update_packages;
+	gboolean		 notify_updates;
+	gboolean		 checking;
+	gboolean		 changed_while_checking;
+
+	GPtrArray		*snapshot_items;
+	gint64			 snapshot_time;
 
 	GpkUpdatesShared	*shared;
 };
 
 enum {
 	HAS_UPDATES,
+	UPDATES_CHANGED,
+	CHECK_FINISHED,
 	ERROR_CHECKING,
 	LAST_SIGNAL
 };
@@ -46,11 +55,70 @@ static guint signals [LAST_SIGNAL] = { 0 };
 
 G_DEFINE_TYPE (GpkUpdatesChecker, gpk_updates_checker, G_TYPE_OBJECT)
 
+static void gpk_updates_checker_pk_check_updates (GpkUpdatesChecker *checker);
+
+
+/*
+ * Save and export the updates, so the update viewer can show them right away.
+ */
+
+static void
+gpk_updates_checker_save_snapshot (GpkUpdatesChecker *checker)
+{
+	GHashTable *known = NULL;
+	GPtrArray *items = NULL;
+	GpkUpdateSnapshotItem *item = NULL, *old_item = NULL;
+	PkPackage *pkg = NULL;
+	GError *error = NULL;
+	guint i;
+
+	/* keep the details the update viewer got for the same versions */
+	known = gpk_update_snapshot_load_index ();
+
+	items = g_ptr_array_new_with_free_func ((GDestroyNotify) gpk_update_snapshot_item_free);
+	for (i = 0; i < checker->update_packages->len; i++) {
+		pkg = g_ptr_array_index (checker->update_packages, i);
+		item = gpk_update_snapshot_item_new (pk_package_get_id (pkg),
+		                                     pk_package_get_info (pkg),
+		                                     pk_package_get_summary (pkg));
+		old_item = g_hash_table_lookup (known, item->package_id);
+		if (old_item != NULL) {
+			item->size = old_item->size;
+			item->restart = old_item->restart;
+			item->update_text = g_strdup (old_item->update_text);
+		}
+		g_ptr_array_add (items, item);
+	}
+
+	if (!gpk_update_snapshot_save (items, &error)) {
+		g_warning ("failed to save the updates snapshot: %s", error->message);
+		g_error_free (error);
+	}
+
+	if (checker->snapshot_items != NULL)
+		g_ptr_array_unref (checker->snapshot_items);
+	checker->snapshot_items = items;
+	checker->snapshot_time = g_get_real_time () / G_USEC_PER_SEC;
+
+	g_hash_table_unref (known);
+}
+
 
 /*
  * Search for updates.
  */
 
+static void
+gpk_updates_checker_check_failed (GpkUpdatesChecker *checker)
+{
+	/* the quiet rechecks are retried by the next scheduled one */
+	if (!checker->notify_updates)
+		return;
+
+	checker->notify_updates = FALSE;
+	g_signal_emit (checker, signals [ERROR_CHECKING], 0);
+}
+
 static void
 gpk_updates_checker_pk_check_updates_finished_cb (GObject           *object,
                                                   GAsyncResult      *res,
@@ -62,6 +130,8 @@ gpk_updates_checker_pk_check_updates_finished_cb (GObject           *object,
 
 	PkClient *client = PK_CLIENT(object);
 
+	checker->checking = FALSE;
+
 	/* get the results */
 	results = pk_client_generic_finish (PK_CLIENT(client), res, &error);
 	if (results == NULL) {
@@ -71,7 +141,7 @@ gpk_updates_checker_pk_check_updates_finished_cb (GObject           *object,
 		}
 		g_warning ("failed to get updates: %s", error->message);
 		g_error_free (error);
-		g_signal_emit (checker, signals [ERROR_CHECKING], 0);
+		gpk_updates_checker_check_failed (checker);
 		goto out;
 	}
 
@@ -87,7 +157,7 @@ gpk_updates_checker_pk_check_updates_finished_cb (GObject           *object,
 				g_debug ("ignoring error");
 				break;
 			default:
-				g_signal_emit (checker, signals [ERROR_CHECKING], 0);
+				gpk_updates_checker_check_failed (checker);
 				break;
 		}
 		goto out;
@@ -97,6 +167,17 @@ gpk_updates_checker_pk_check_updates_finished_cb (GObject           *object,
 	if (checker->update_packages != NULL)
 		g_ptr_array_unref (checker->update_packages);
 	checker->update_packages = pk_results_get_package_array (results);
+	gpk_updates_checker_save_snapshot (checker);
+	g_signal_emit (checker, signals [UPDATES_CHANGED], 0);
+
+	/* just keep the list up to date when the updates changed by others,
+	 * only the first answer after a scheduled check is notified */
+	if (!checker->notify_updates) {
+		g_debug ("updates list refreshed");
+		goto out;
+	}
+	checker->notify_updates = FALSE;
+	g_signal_emit (checker, signals [CHECK_FINISHED], 0);
 
 	/* we have no updates */
 	if (checker->update_packages->len == 0) {
@@ -113,6 +194,12 @@ out:
 		g_object_unref (error_code);
 	if (results != NULL)
 		g_object_unref (results);
+
+	/* PackageKit said the updates changed while checking */
+	if (checker->changed_while_checking) {
+		g_debug ("updates changed, refreshing the updates list");
+		gpk_updates_checker_pk_check_updates (checker);
+	}
 }
 
 static void
@@ -123,6 +210,9 @@ gpk_updates_checker_pk_check_updates (GpkUpdatesChecker *checker)
 	                         g_settings_get_int (gpk_updates_shared_get_settings (checker->shared),
 	                                             GPK_SETTINGS_FREQUENCY_GET_UPDATES));
 
+	checker->checking = TRUE;
+	checker->changed_while_checking = FALSE;
+
 	/* get new update list */
 	pk_client_get_updates_async (PK_CLIENT(gpk_updates_shared_get_pk_task (checker->shared)),
 	                             pk_bitfield_value (PK_FILTER_ENUM_NONE),
@@ -160,25 +250,45 @@ gpk_updates_checker_get_updates_count (GpkUpdatesChecker *checker)
 	return 0;
 }
 
-gchar **
-gpk_updates_checker_get_update_packages_ids (GpkUpdatesChecker *checker)
+GPtrArray *
+gpk_updates_checker_get_update_packages (GpkUpdatesChecker *checker)
 {
-	PkPackage *pkg;
-	gchar **package_ids;
-	guint i;
+	return checker->update_packages;
+}
 
-	package_ids = g_new0 (gchar *, checker->update_packages->len + 1);
-	for (i = 0; i < checker->update_packages->len; i++) {
-		pkg = g_ptr_array_index (checker->update_packages, i);
-		package_ids[i] = g_strdup (pk_package_get_id (pkg));
-	}
+GPtrArray *
+gpk_updates_checker_get_snapshot (GpkUpdatesChecker *checker, gint64 *timestamp)
+{
+	if (timestamp != NULL)
+		*timestamp = checker->snapshot_time;
 
-	return package_ids;
+	return checker->snapshot_items;
 }
 
 void
 gpk_updates_checker_check_for_updates (GpkUpdatesChecker *checker)
 {
+	checker->notify_updates = TRUE;
+	gpk_updates_checker_pk_check_updates (checker);
+}
+
+static void
+gpk_updates_checker_pk_updates_changed_cb (PkControl         *control,
+                                           GpkUpdatesChecker *checker)
+{
+	/* nothing to keep up to date until the first check */
+	if (checker->snapshot_time == 0)
+		return;
+
+	/* the running check may have got the list before the change, so
+	 * ask again once it finishes instead of running both at once */
+	if (checker->checking) {
+		g_debug ("updates changed while checking, waiting for it");
+		checker->changed_while_checking = TRUE;
+		return;
+	}
+
+	g_debug ("updates changed, refreshing the updates list");
 	gpk_updates_checker_pk_check_updates (checker);
 }
 
@@ -191,10 +301,19 @@ gpk_updates_checker_dispose (GObject *object)
 
 	g_debug ("Stopping updates checker");
 
+	if (checker->shared != NULL)
+		g_signal_handlers_disconnect_by_data (gpk_updates_shared_get_pk_control (checker->shared), checker);
 	g_clear_object (&checker->shared);
 
-	if (checker->update_packages != NULL)
+	if (checker->update_packages != NULL) {
 		g_ptr_array_unref (checker->update_packages);
+		checker->update_packages = NULL;
+	}
+
+	if (checker->snapshot_items != NULL) {
+		g_ptr_array_unref (checker->snapshot_items);
+		checker->snapshot_items = NULL;
+	}
 
 	g_debug ("Stopped pdates checker");
 
@@ -214,6 +333,18 @@ gpk_updates_checker_class_init (GpkUpdatesCheckerClass *klass)
 		              0, NULL, NULL, g_cclosure_marshal_VOID__VOID,
 		              G_TYPE_NONE, 0);
 
+	signals [UPDATES_CHANGED] =
+		g_signal_new ("updates-changed",
+		              G_TYPE_FROM_CLASS (object_class), G_SIGNAL_RUN_LAST,
+		              0, NULL, NULL, g_cclosure_marshal_VOID__VOID,
+		              G_TYPE_NONE, 0);
+
+	signals [CHECK_FINISHED] =
+		g_signal_new ("check-finished",
+		              G_TYPE_FROM_CLASS (object_class), G_SIGNAL_RUN_LAST,
+		              0, NULL, NULL, g_cclosure_marshal_VOID__VOID,
+		              G_TYPE_NONE, 0);
+
 	signals [ERROR_CHECKING] =
 		g_signal_new ("error-checking",
 		              G_TYPE_FROM_CLASS (object_class), G_SIGNAL_RUN_LAST,
@@ -229,6 +360,10 @@ gpk_updates_checker_init (GpkUpdatesChecker *checker)
 	/* The shared code between the different tasks */
 	checker->shared = gpk_updates_shared_get ();
 
+	/* keep the exported list in sync after installing updates */
+	g_signal_connect (gpk_updates_shared_get_pk_control (checker->shared), "updates-changed",
+	                  G_CALLBACK (gpk_updates_checker_pk_updates_changed_cb), checker);
+
 	g_debug ("Started updates checker");
 }
 
@@ -32,7 +32,10 @@ guint              gpk_updates_checker_get_important_updates_count (GpkUpdatesCh
 
 guint              gpk_updates_checker_get_updates_count           (GpkUpdatesChecker *checker);
 
-gchar            **gpk_updates_checker_get_update_packages_ids     (GpkUpdatesChecker *checker);
+GPtrArray         *gpk_updates_checker_get_update_packages         (GpkUpdatesChecker *checker);
+
+GPtrArray         *gpk_updates_checker_get_snapshot                (GpkUpdatesChecker *checker,
+                                                                    gint64            *timestamp);
 
 void               gpk_updates_checker_check_for_updates           (GpkUpdatesChecker *checker);
 
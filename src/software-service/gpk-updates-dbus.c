@@ -0,0 +1,261 @@
+/* -*- Mode: C; tab-width: 8; indent-tabs-mode: t; c-basic-offset: 8 -*-
+ *
+ * Copyright (C) 2022 Matias De lellis <mati86dl@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "config.h"
+
+#include <gio/gio.h>
+
+#include <common/gpk-common.h>
+#include <common/gpk-update-snapshot.h>
+
+#include "gpk-updates-dbus.h"
+
+struct _GpkUpdatesDbus
+{
+	GObject			_parent;
+
+	GpkUpdatesChecker	*checker;
+
+	GDBusNodeInfo		*introspection;
+	GDBusConnection		*connection;
+	guint			 owner_id;
+	guint			 registration_id;
+};
+
+G_DEFINE_TYPE (GpkUpdatesDbus, gpk_updates_dbus, G_TYPE_OBJECT)
+
+static const gchar introspection_xml[] =
+	"<node>"
+	"  <interface name='" GPK_UPDATES_DBUS_INTERFACE "'>"
+	"    <method name='GetUpdates'>"
+	"      <arg type='x' name='timestamp' direction='out'/>"
+	"      <arg type='a" GPK_UPDATE_SNAPSHOT_RECORD "' name='updates' direction='out'/>"
+	"    </method>"
+	"    <signal name='UpdatesChanged'/>"
+	"    <signal name='DownloadProgress'>"
+	"      <arg type='u' name='percentage'/>"
+	"    </signal>"
+	"  </interface>"
+	"</node>";
+
+
+/*
+ * Export the updates found by the checker.
+ */
+
+static void
+gpk_updates_dbus_method_call (GDBusConnection       *connection,
+                              const gchar           *sender,
+                              const gchar           *object_path,
+                              const gchar           *interface_name,
+                              const gchar           *method_name,
+                              GVariant              *parameters,
+                              GDBusMethodInvocation *invocation,
+                              gpointer               user_data)
+{
+	GpkUpdatesDbus *dbus = GPK_UPDATES_DBUS (user_data);
+	GPtrArray *items = NULL;
+	gint64 timestamp = 0;
+
+	if (g_strcmp0 (method_name, "GetUpdates") == 0) {
+		/* a zero timestamp means that there was no check yet */
+		items = gpk_updates_checker_get_snapshot (dbus->checker, &timestamp);
+		g_dbus_method_invocation_return_value (invocation,
+		                                       g_variant_new ("(x@a" GPK_UPDATE_SNAPSHOT_RECORD ")",
+		                                                      timestamp,
+		                                                      gpk_update_snapshot_to_variant (items)));
+		return;
+	}
+
+	g_dbus_method_invocation_return_error (invocation,
+	                                       G_DBUS_ERROR,
+	                                       G_DBUS_ERROR_UNKNOWN_METHOD,
+	                                       "Unknown method %s", method_name);
+}
+
+static const GDBusInterfaceVTable interface_vtable = {
+	gpk_updates_dbus_method_call,
+	NULL,
+	NULL
+};
+
+static void
+gpk_updates_dbus_checker_updates_changed_cb (GpkUpdatesChecker *checker,
+                                             GpkUpdatesDbus    *dbus)
+{
+	GError *error = NULL;
+
+	if (dbus->registration_id == 0)
+		return;
+
+	g_debug ("Emitting UpdatesChanged");
+	if (!g_dbus_connection_emit_signal (dbus->connection,
+	                                    NULL,
+	                                    GPK_UPDATES_DBUS_PATH,
+	                                    GPK_UPDATES_DBUS_INTERFACE,
+	                                    "UpdatesChanged",
+	                                    NULL,
+	                                    &error)) {
+		g_warning ("failed to emit UpdatesChanged: %s", error->message);
+		g_error_free (error);
+	}
+}
+
+void
+gpk_updates_dbus_emit_download_progress (GpkUpdatesDbus *dbus, guint percentage)
+{
+	GError *error = NULL;
+
+	if (dbus->registration_id == 0)
+		return;
+
+	if (!g_dbus_connection_emit_signal (dbus->connection,
+	                                    NULL,
+	                                    GPK_UPDATES_DBUS_PATH,
+	                                    GPK_UPDATES_DBUS_INTERFACE,
+	                                    "DownloadProgress",
+	                                    g_variant_new ("(u)", percentage),
+	                                    &error)) {
+		g_warning ("failed to emit DownloadProgress: %s", error->message);
+		g_error_free (error);
+	}
+}
+
+
+/*
+ * Own the name on the session bus.
+ */
+
+static void
+gpk_updates_dbus_bus_acquired_cb (GDBusConnection *connection,
+                                  const gchar     *name,
+                                  gpointer         user_data)
+{
+	GpkUpdatesDbus *dbus = GPK_UPDATES_DBUS (user_data);
+	GError *error = NULL;
+
+	dbus->connection = g_object_ref (connection);
+	dbus->registration_id =
+		g_dbus_connection_register_object (connection,
+		                                   GPK_UPDATES_DBUS_PATH,
+		                                   dbus->introspection->interfaces[0],
+		                                   &interface_vtable,
+		                                   dbus,
+		                                   NULL,
+		                                   &error);
+	if (dbus->registration_id == 0) {
+		g_warning ("failed to export the updates: %s", error->message);
+		g_error_free (error);
+	}
+}
+
+static void
+gpk_updates_dbus_name_acquired_cb (GDBusConnection *connection,
+                                   const gchar     *name,
+                                   gpointer         user_data)
+{
+	g_debug ("Acquired the name %s", name);
+}
+
+static void
+gpk_updates_dbus_name_lost_cb (GDBusConnection *connection,
+                               const gchar     *name,
+                               gpointer         user_data)
+{
+	g_warning ("Lost the name %s, the update viewer will ask PackageKit", name);
+}
+
+
+/**
+ *  GpkUpdatesDbus:
+ */
+
+static void
+gpk_updates_dbus_dispose (GObject *object)
+{
+	GpkUpdatesDbus *dbus;
+
+	dbus = GPK_UPDATES_DBUS (object);
+
+	g_debug ("Stopping updates dbus");
+
+	if (dbus->checker != NULL)
+		g_signal_handlers_disconnect_by_data (dbus->checker, dbus);
+	g_clear_object (&dbus->checker);
+
+	if (dbus->registration_id > 0) {
+		g_dbus_connection_unregister_object (dbus->connection, dbus->registration_id);
+		dbus->registration_id = 0;
+	}
+
+	if (dbus->owner_id > 0) {
+		g_bus_unown_name (dbus->owner_id);
+		dbus->owner_id = 0;
+	}
+
+	g_clear_object (&dbus->connection);
+
+	if (dbus->introspection != NULL) {
+		g_dbus_node_info_unref (dbus->introspection);
+		dbus->introspection = NULL;
+	}
+
+	g_debug ("Stopped updates dbus");
+
+	G_OBJECT_CLASS (gpk_updates_dbus_parent_class)->dispose (object);
+}
+
+static void
+gpk_updates_dbus_class_init (GpkUpdatesDbusClass *klass)
+{
+	GObjectClass *object_class = G_OBJECT_CLASS (klass);
+
+	object_class->dispose = gpk_updates_dbus_dispose;
+}
+
+static void
+gpk_updates_dbus_init (GpkUpdatesDbus *dbus)
+{
+	g_debug ("Starting updates dbus");
+
+	dbus->introspection = g_dbus_node_info_new_for_xml (introspection_xml, NULL);
+	g_assert (dbus->introspection != NULL);
+
+	dbus->owner_id = g_bus_own_name (G_BUS_TYPE_SESSION,
+	                                 GPK_UPDATES_DBUS_NAME,
+	                                 G_BUS_NAME_OWNER_FLAGS_NONE,
+	                                 gpk_updates_dbus_bus_acquired_cb,
+	                                 gpk_updates_dbus_name_acquired_cb,
+	                                 gpk_updates_dbus_name_lost_cb,
+	                                 dbus,
+	                                 NULL);
+
+	g_debug ("Started updates dbus");
+}
+
+GpkUpdatesDbus *
+gpk_updates_dbus_new (GpkUpdatesChecker *checker)
+{
+	GpkUpdatesDbus *dbus;
+	dbus = g_object_new (GPK_TYPE_UPDATES_DBUS, NULL);
+	dbus->checker = g_object_ref (checker);
+	g_signal_connect (dbus->checker, "updates-changed",
+	                  G_CALLBACK (gpk_updates_dbus_checker_updates_changed_cb), dbus);
+	return GPK_UPDATES_DBUS (dbus);
+}
@@ -0,0 +1,40 @@
+/* -*- Mode: C; tab-width: 8; indent-tabs-mode: nil; c-basic-offset: 8 -*-
+ *
+ * Copyright (C) 2022 Matias De lellis <mati86dl@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef __GPK_UPDATES_DBUS_H
+#define __GPK_UPDATES_DBUS_H
+
+#include <glib-object.h>
+
+#include "gpk-updates-checker.h"
+
+G_BEGIN_DECLS
+
+#define GPK_TYPE_UPDATES_DBUS (gpk_updates_dbus_get_type ())
+
+G_DECLARE_FINAL_TYPE (GpkUpdatesDbus, gpk_updates_dbus, GPK, UPDATES_DBUS, GObject)
+
+void            gpk_updates_dbus_emit_download_progress (GpkUpdatesDbus *dbus,
+                                                         guint           percentage);
+
+GpkUpdatesDbus *gpk_updates_dbus_new (GpkUpdatesChecker *checker);
+
+G_END_DECLS
+
+#endif /* __GPK_UPDATES_DBUS_H */
@@ -19,7 +19,9 @@
 
 #include "config.h"
 
+#include <errno.h>
 #include <glib/gi18n.h>
+#include <glib/gstdio.h>
 
 #include <common/gpk-common.h>
 
@@ -27,15 +29,37 @@
 
 #include "gpk-updates-download.h"
 
+#define GPK_UPDATES_DOWNLOAD_BATCH	20 /* packages */
+
 struct _GpkUpdatesDownload
 {
 	GObject			_parent;
 
 	GpkUpdatesShared	*shared;
+
+	guint			 download_rate;
+
+	GPtrArray		*package_ids;	/* all the updates, by priority */
+	guint			 important_len;	/* the security and important ones */
+	gboolean		 important_ready;
+	GHashTable		*downloaded;	/* the ones of finished batches */
+	guint			 batch_start;
+	guint			 batch_len;
+	gboolean		 batch_last;
+	GCancellable		*cancellable;	/* of the running batch */
+	guint			 percentage;
 };
 
+typedef struct {
+	GpkUpdatesDownload	*download;
+	GCancellable		*cancellable;
+	guint			 size;
+} GpkUpdatesDownloadBatch;
+
 enum {
 	DOWNLOAD_DONE,
+	IMPORTANT_DONE,
+	DOWNLOAD_PROGRESS,
 	ERROR_DOWNLOADING,
 	LAST_SIGNAL
 };
@@ -44,27 +68,195 @@ static guint signals [LAST_SIGNAL] = { 0 };
 
 G_DEFINE_TYPE (GpkUpdatesDownload, gpk_updates_download, G_TYPE_OBJECT)
 
+#define GPK_UPDATES_DOWNLOAD_PRIORITY_IMPORTANT	1
+#define GPK_UPDATES_DOWNLOAD_PRIORITY_LAST	4
+
+static void gpk_updates_download_next_batch (GpkUpdatesDownload *download);
+
+
+/*
+ * Remember the finished batches, so a new attempt does not start over.
+ */
+
+static gchar *
+gpk_updates_download_get_filename (void)
+{
+	return g_build_filename (g_get_user_cache_dir (),
+	                         "xings-software",
+	                         "downloaded-updates",
+	                         NULL);
+}
+
+static void
+gpk_updates_download_load_downloaded (GpkUpdatesDownload *download)
+{
+	GHashTable *wanted;
+	gchar *filename = NULL, *contents = NULL;
+	gchar **lines = NULL;
+	guint i;
+
+	g_hash_table_remove_all (download->downloaded);
+
+	filename = gpk_updates_download_get_filename ();
+	if (!g_file_get_contents (filename, &contents, NULL, NULL))
+		goto out;
+
+	/* only the same versions of the updates that are still wanted */
+	wanted = g_hash_table_new (g_str_hash, g_str_equal);
+	for (i = 0; i < download->package_ids->len; i++)
+		g_hash_table_add (wanted, g_ptr_array_index (download->package_ids, i));
+
+	lines = g_strsplit (contents, "\n", -1);
+	for (i = 0; lines[i] != NULL; i++) {
+		if (g_hash_table_contains (wanted, lines[i]))
+			g_hash_table_add (download->downloaded, g_strdup (lines[i]));
+	}
+	g_hash_table_unref (wanted);
+
+	g_debug ("%u updates were already downloaded", g_hash_table_size (download->downloaded));
+
+out:
+	g_strfreev (lines);
+	g_free (contents);
+	g_free (filename);
+}
+
+static void
+gpk_updates_download_save_downloaded (GpkUpdatesDownload *download)
+{
+	GHashTableIter iter;
+	GString *contents;
+	GError *error = NULL;
+	gchar *filename = NULL, *dirname = NULL;
+	gpointer key;
+
+	contents = g_string_new (NULL);
+	g_hash_table_iter_init (&iter, download->downloaded);
+	while (g_hash_table_iter_next (&iter, &key, NULL))
+		g_string_append_printf (contents, "%s\n", (const gchar *) key);
+
+	filename = gpk_updates_download_get_filename ();
+	dirname = g_path_get_dirname (filename);
+	if (g_mkdir_with_parents (dirname, 0700) != 0) {
+		g_warning ("failed to create %s: %s", dirname, g_strerror (errno));
+		goto out;
+	}
+
+	if (!g_file_set_contents (filename, contents->str, (gssize) contents->len, &error)) {
+		g_warning ("failed to save the downloaded updates: %s", error->message);
+		g_error_free (error);
+	}
+
+out:
+	g_string_free (contents, TRUE);
+	g_free (dirname);
+	g_free (filename);
+}
+
+
+/*
+ * Download the updates in batches.
+ */
+
+static void
+gpk_updates_download_batch_free (GpkUpdatesDownloadBatch *batch)
+{
+	g_object_unref (batch->cancellable);
+	g_free (batch);
+}
+
+static void
+gpk_updates_download_save_rate (GpkUpdatesDownload *download)
+{
+	GSettings *settings = gpk_updates_shared_get_settings (download->shared);
+
+	/* so the update viewer can estimate how long the download takes */
+	if (download->download_rate == g_settings_get_uint (settings, GPK_SETTINGS_DOWNLOAD_RATE))
+		return;
+
+	g_debug ("download rate is now %u bytes per second", download->download_rate);
+	g_settings_set_uint (settings, GPK_SETTINGS_DOWNLOAD_RATE, download->download_rate);
+}
+
+static void
+gpk_updates_download_set_percentage (GpkUpdatesDownload *download, guint percentage)
+{
+	if (percentage == download->percentage)
+		return;
+
+	download->percentage = percentage;
+	g_signal_emit (download, signals [DOWNLOAD_PROGRESS], 0, percentage);
+}
+
+static void
+gpk_updates_download_pk_progress_cb (PkProgress              *progress,
+                                     PkProgressType           type,
+                                     GpkUpdatesDownloadBatch *batch)
+{
+	GpkUpdatesDownload *download = batch->download;
+	PkStatusEnum status;
+	guint speed, done;
+	gint percentage;
+
+	if (g_cancellable_is_cancelled (batch->cancellable))
+		return;
+
+	if (type == PK_PROGRESS_TYPE_SPEED) {
+		g_object_get (progress,
+		              "status", &status,
+		              "speed", &speed,
+		              NULL);
+
+		/* the speed is in bits per second */
+		if (status == PK_STATUS_ENUM_DOWNLOAD)
+			download->download_rate = gpk_download_rate_update (download->download_rate, speed / 8);
+
+	} else if (type == PK_PROGRESS_TYPE_PERCENTAGE && !download->batch_last) {
+		g_object_get (progress,
+		              "percentage", &percentage,
+		              NULL);
+		if (percentage < 0)
+			return;
+
+		/* the progress of all the updates, not only of this batch */
+		done = g_hash_table_size (download->downloaded);
+		gpk_updates_download_set_percentage (download,
+		                                     (done * 100 + batch->size * (guint) percentage) /
+		                                     download->package_ids->len);
+	}
+}
+
 static void
-gpk_updates_download_pk_download_finished_cb (GObject            *object,
-                                              GAsyncResult       *res,
-                                              GpkUpdatesDownload *download)
+gpk_updates_download_pk_download_finished_cb (GObject                 *object,
+                                              GAsyncResult            *res,
+                                              GpkUpdatesDownloadBatch *batch)
 {
+	GpkUpdatesDownload *download = batch->download;
 	PkClient *client = PK_CLIENT(object);
 	PkResults *results;
 	PkError *error_code = NULL;
 	GError *error = NULL;
+	guint i;
 
 	/* get the results */
 	results = pk_client_generic_finish (PK_CLIENT(client), res, &error);
+
+	/* paused, or replaced by a new list of updates */
+	if (g_cancellable_is_cancelled (batch->cancellable)) {
+		g_debug ("download of the batch was stopped");
+		g_clear_error (&error);
+		goto out;
+	}
+	g_clear_object (&download->cancellable);
+
+	/* also learn from the failed downloads */
+	gpk_updates_download_save_rate (download);
+
 	if (results == NULL) {
-		if (g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED)) {
-			g_error_free (error);
-			return;
-		}
 		g_warning ("failed to download: %s", error->message);
 		g_error_free (error);
 		g_signal_emit (download, signals [ERROR_DOWNLOADING], 0);
-		return;
+		goto out;
 	}
 
 	/* check error code */
@@ -73,38 +265,178 @@ gpk_updates_download_pk_download_finished_cb (GObject            *object,
 		g_warning ("failed to download: %s, %s",
 		           pk_error_enum_to_string (pk_error_get_code (error_code)),
 		           pk_error_get_details (error_code));
-		switch (pk_error_get_code (error_code)) {
-			case PK_ERROR_ENUM_CANCELLED_PRIORITY:
-			case PK_ERROR_ENUM_TRANSACTION_CANCELLED:
-				g_debug ("ignoring error");
-				break;
-			default:
-				g_signal_emit (download, signals [ERROR_DOWNLOADING], 0);
-				break;
-		}
+		/* our own pause was handled above, so even a cancel came from
+		 * PackageKit, and the batch has to be tried again */
+		g_signal_emit (download, signals [ERROR_DOWNLOADING], 0);
+		goto out;
+	}
+
+	if (download->batch_last && !download->important_ready &&
+	    download->important_len < download->package_ids->len) {
+		/* the rest waits for the caller to allow it */
+		g_debug ("important updates downloaded");
+		download->important_ready = TRUE;
+		download->batch_start = download->important_len;
+		g_signal_emit (download, signals [IMPORTANT_DONE], 0);
+		goto out;
+	}
+
+	if (download->batch_last) {
+		g_debug ("updates downloaded");
+		download->important_ready = TRUE;
+		gpk_updates_download_set_percentage (download, 100);
+		g_signal_emit (download, signals [DOWNLOAD_DONE], 0);
 		goto out;
 	}
 
-	g_debug ("updates downloaded");
-	g_signal_emit (download, signals [DOWNLOAD_DONE], 0);
+	/* keep the batch, even if the next one fails */
+	for (i = download->batch_start; i < download->batch_start + download->batch_len; i++)
+		g_hash_table_add (download->downloaded, g_strdup (g_ptr_array_index (download->package_ids, i)));
+	gpk_updates_download_save_downloaded (download);
+
+	download->batch_start += download->batch_len;
+	gpk_updates_download_next_batch (download);
 
 out:
 	if (error_code != NULL)
 		g_object_unref (error_code);
 	if (results != NULL)
 		g_object_unref (results);
+	gpk_updates_download_batch_free (batch);
 }
 
 static void
-gpk_updates_download_pk_auto_download_updates (GpkUpdatesDownload *download, gchar **package_ids)
+gpk_updates_download_next_batch (GpkUpdatesDownload *download)
 {
+	GpkUpdatesDownloadBatch *batch;
+	GPtrArray *ids;
+	const gchar *package_id;
+	guint end, i;
+
+	/* the important updates first, and ready to install on their own */
+	end = download->package_ids->len;
+	if (!download->important_ready)
+		end = download->important_len;
+
+	/* the next updates that are not downloaded yet */
+	ids = g_ptr_array_new ();
+	for (i = download->batch_start;
+	     i < end && ids->len < GPK_UPDATES_DOWNLOAD_BATCH;
+	     i++) {
+		package_id = g_ptr_array_index (download->package_ids, i);
+		if (!g_hash_table_contains (download->downloaded, package_id))
+			g_ptr_array_add (ids, (gpointer) package_id);
+	}
+	download->batch_len = i - download->batch_start;
+
+	/* PackageKit prepares the offline update with the packages of the
+	 * last transaction, so end with all of them, already in the cache */
+	download->batch_last = (ids->len == 0 || ids->len == end);
+	if (ids->len == 0) {
+		for (i = 0; i < end; i++)
+			g_ptr_array_add (ids, g_ptr_array_index (download->package_ids, i));
+	}
+	g_ptr_array_add (ids, NULL);
+
+	g_debug ("downloading %u updates from %u", ids->len - 1, download->batch_start);
+
+	batch = g_new0 (GpkUpdatesDownloadBatch, 1);
+	batch->download = download;
+	batch->size = ids->len - 1;
+	download->cancellable = g_cancellable_new ();
+	batch->cancellable = g_object_ref (download->cancellable);
+
 	/* we've set only-download in PkTask */
 	pk_task_update_packages_async (gpk_updates_shared_get_pk_task (download->shared),
-	                               package_ids,
-	                               gpk_updates_shared_get_cancellable (download->shared),
-	                               NULL, NULL,
+	                               (gchar **) ids->pdata,
+	                               batch->cancellable,
+	                               (PkProgressCallback) gpk_updates_download_pk_progress_cb, batch,
 	                               (GAsyncReadyCallback) gpk_updates_download_pk_download_finished_cb,
-	                               download);
+	                               batch);
+	g_ptr_array_unref (ids);
+}
+
+static guint
+gpk_updates_download_get_priority (PkPackage *pkg)
+{
+	switch (pk_package_get_info (pkg)) {
+		case PK_INFO_ENUM_SECURITY:
+			return 0;
+		case PK_INFO_ENUM_IMPORTANT:
+			return GPK_UPDATES_DOWNLOAD_PRIORITY_IMPORTANT;
+		case PK_INFO_ENUM_BUGFIX:
+			return 2;
+		case PK_INFO_ENUM_LOW:
+			return GPK_UPDATES_DOWNLOAD_PRIORITY_LAST;
+		default:
+			return 3;
+	}
+}
+
+void
+gpk_updates_download_set_updates (GpkUpdatesDownload *download, GPtrArray *packages)
+{
+	PkPackage *pkg;
+	guint priority, i;
+
+	gpk_updates_download_pause (download);
+
+	/* the most important updates first */
+	g_ptr_array_set_size (download->package_ids, 0);
+	for (priority = 0; priority <= GPK_UPDATES_DOWNLOAD_PRIORITY_LAST; priority++) {
+		for (i = 0; i < packages->len; i++) {
+			pkg = g_ptr_array_index (packages, i);
+			if (gpk_updates_download_get_priority (pkg) == priority)
+				g_ptr_array_add (download->package_ids, g_strdup (pk_package_get_id (pkg)));
+		}
+		if (priority == GPK_UPDATES_DOWNLOAD_PRIORITY_IMPORTANT)
+			download->important_len = download->package_ids->len;
+	}
+	download->important_ready = (download->important_len == 0);
+
+	gpk_updates_download_load_downloaded (download);
+	download->batch_start = 0;
+	download->percentage = 0;
+}
+
+gboolean
+gpk_updates_download_start (GpkUpdatesDownload *download)
+{
+	if (download->cancellable != NULL)
+		return TRUE;
+	if (download->package_ids->len == 0)
+		return FALSE;
+
+	/* start from the rate the update viewer may also have learned */
+	download->download_rate = g_settings_get_uint (gpk_updates_shared_get_settings (download->shared),
+	                                               GPK_SETTINGS_DOWNLOAD_RATE);
+
+	gpk_updates_download_next_batch (download);
+	return TRUE;
+}
+
+void
+gpk_updates_download_pause (GpkUpdatesDownload *download)
+{
+	if (download->cancellable == NULL)
+		return;
+
+	/* the finished batches are kept, the running one starts again */
+	g_debug ("pausing the download of updates");
+	g_cancellable_cancel (download->cancellable);
+	g_clear_object (&download->cancellable);
+}
+
+gboolean
+gpk_updates_download_is_running (GpkUpdatesDownload *download)
+{
+	return download->cancellable != NULL;
+}
+
+gboolean
+gpk_updates_download_get_important_ready (GpkUpdatesDownload *download)
+{
+	return download->important_ready;
 }
 
 static void
@@ -116,6 +448,12 @@ gpk_updates_download_dispose (GObject *object)
 
 	g_debug ("Stopping updates download");
 
+	if (download->cancellable != NULL)
+		gpk_updates_download_pause (download);
+
+	g_clear_pointer (&download->package_ids, g_ptr_array_unref);
+	g_clear_pointer (&download->downloaded, g_hash_table_unref);
+
 	g_clear_object (&download->shared);
 
 	g_debug ("Stopped pdates download");
@@ -136,6 +474,18 @@ gpk_updates_download_class_init (GpkUpdatesDownloadClass *klass)
 		              0, NULL, NULL, g_cclosure_marshal_VOID__VOID,
 		              G_TYPE_NONE, 0);
 
+	signals [IMPORTANT_DONE] =
+		g_signal_new ("important-done",
+		              G_TYPE_FROM_CLASS (object_class), G_SIGNAL_RUN_LAST,
+		              0, NULL, NULL, g_cclosure_marshal_VOID__VOID,
+		              G_TYPE_NONE, 0);
+
+	signals [DOWNLOAD_PROGRESS] =
+		g_signal_new ("download-progress",
+		              G_TYPE_FROM_CLASS (object_class), G_SIGNAL_RUN_LAST,
+		              0, NULL, NULL, g_cclosure_marshal_VOID__UINT,
+		              G_TYPE_NONE, 1, G_TYPE_UINT);
+
 	signals [ERROR_DOWNLOADING] =
 		g_signal_new ("error-downloading",
 		              G_TYPE_FROM_CLASS (object_class), G_SIGNAL_RUN_LAST,
@@ -151,13 +501,10 @@ gpk_updates_download_init (GpkUpdatesDownload *download)
 	/* The shared code between the different tasks */
 	download->shared = gpk_updates_shared_get ();
 
-	g_debug ("Started updates download");
-}
+	download->package_ids = g_ptr_array_new_with_free_func (g_free);
+	download->downloaded = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
 
-void
-gpk_updates_download_auto_download_updates (GpkUpdatesDownload *download, gchar **package_ids)
-{
-	gpk_updates_download_pk_auto_download_updates (download, package_ids);
+	g_debug ("Started updates download");
 }
 
 GpkUpdatesDownload *
@@ -28,7 +28,11 @@ G_BEGIN_DECLS
 
 G_DECLARE_FINAL_TYPE (GpkUpdatesDownload, gpk_updates_download, GPK, UPDATES_DOWNLOAD, GObject)
 
-void                gpk_updates_download_auto_download_updates (GpkUpdatesDownload *download, gchar **package_ids);
+void                gpk_updates_download_set_updates           (GpkUpdatesDownload *download, GPtrArray *packages);
+gboolean            gpk_updates_download_start                 (GpkUpdatesDownload *download);
+void                gpk_updates_download_pause                 (GpkUpdatesDownload *download);
+gboolean            gpk_updates_download_is_running            (GpkUpdatesDownload *download);
+gboolean            gpk_updates_download_get_important_ready   (GpkUpdatesDownload *download);
 
 GpkUpdatesDownload *gpk_updates_download_new (void);
 
@@ -19,12 +19,15 @@
 
 #include "config.h"
 
+#include <string.h>
+
 #include <common/gpk-common.h>
 #include <common/gpk-session.h>
 
 #include "gpk-updates-notification.h"
 
 #include "gpk-updates-checker.h"
+#include "gpk-updates-dbus.h"
 #include "gpk-updates-download.h"
 #include "gpk-updates-refresh.h"
 #include "gpk-updates-shared.h"
@@ -42,6 +45,24 @@ typedef enum {
 	UP_DEVICE_LEVEL_LAST
 } UpDeviceLevel;
 
+typedef enum {
+	UP_DEVICE_STATE_UNKNOWN,
+	UP_DEVICE_STATE_CHARGING,
+	UP_DEVICE_STATE_DISCHARGING,
+	UP_DEVICE_STATE_EMPTY,
+	UP_DEVICE_STATE_FULLY_CHARGED,
+	UP_DEVICE_STATE_PENDING_CHARGE,
+	UP_DEVICE_STATE_PENDING_DISCHARGE,
+	UP_DEVICE_STATE_LAST
+} UpDeviceState;
+
+/* The work that waits for the network or the power to allow it */
+typedef enum {
+	GPK_UPDATES_WORK_REFRESH	= 1 << 0,	/* refresh and check */
+	GPK_UPDATES_WORK_DOWNLOAD	= 1 << 1,	/* security and important */
+	GPK_UPDATES_WORK_DOWNLOAD_REST	= 1 << 2
+} GpkUpdatesWork;
+
 struct _GpkUpdatesManager
 {
 	GObject			_parent;
@@ -49,15 +70,26 @@ struct _GpkUpdatesManager
 	GpkUpdatesShared	*shared;
 
 	guint			 check_startup_id;	/* 60s after startup */
-	guint			 check_hourly_id;	/* and then every hour */
+	guint			 check_id;		/* and then when due */
+	guint			 check_failures;
+	guint			 download_failures;
+	guint			 download_retry_id;
+	guint			 pending_work;
+	gboolean		 important_notified;
+	gint64			 busy_since;		/* when the work began to wait */
+	guint			 busy_check_id;
+	guint			 host_hash;
 
 	GDBusProxy		*proxy_upower;
+	GDBusProxy		*proxy_presence;
+	gboolean		 session_idle;
 	GNetworkMonitor		*network_monitor;
 
 	guint			 dbus_watch_id;
 
 	GpkUpdatesRefresh	*refresh;
 	GpkUpdatesChecker	*checker;
+	GpkUpdatesDbus		*dbus;
 	GpkUpdatesDownload	*download;
 
 	GpkUpdatesNotification	*notification;
@@ -65,6 +97,8 @@ struct _GpkUpdatesManager
 
 G_DEFINE_TYPE (GpkUpdatesManager, gpk_updates_manager, G_TYPE_OBJECT)
 
+static void gpk_updates_manager_run_pending_work (GpkUpdatesManager *manager);
+
 
 /**
  *  Common definitions.
@@ -72,6 +106,25 @@ G_DEFINE_TYPE (GpkUpdatesManager, gpk_updates_manager, G_TYPE_OBJECT)
 
 #define SECONDS_IN_AN_HOUR (60 * 60)
 
+/* never wake up more often than this, even when a refresh is due */
+#define GPK_UPDATES_MANAGER_CHECK_MIN		(15 * 60)
+/* wake up at least this often, to follow the changes of the settings */
+#define GPK_UPDATES_MANAGER_CHECK_MAX		SECONDS_IN_AN_HOUR
+/* the backoff after failures, doubled on each one */
+#define GPK_UPDATES_MANAGER_RETRY_MIN		(5 * 60)
+#define GPK_UPDATES_MANAGER_RETRY_MAX		(6 * SECONDS_IN_AN_HOUR)
+/* wait for the connection to settle after coming back */
+#define GPK_UPDATES_MANAGER_WAKE_DELAY		30
+/* look again at the load while waiting for an idle computer */
+#define GPK_UPDATES_MANAGER_BUSY_RECHECK	(5 * 60)
+/* percent of time stalled on a resource, on the last minute */
+#define GPK_UPDATES_MANAGER_BUSY_PRESSURE	20.0
+/* runnable tasks per processor, when there is no pressure information */
+#define GPK_UPDATES_MANAGER_BUSY_LOAD		0.75
+
+/* the status of org.gnome.SessionManager.Presence */
+#define GPK_UPDATES_MANAGER_PRESENCE_IDLE	3
+
 
 /**
  *  Utils
@@ -115,6 +168,125 @@ out:
 	return level;
 }
 
+static gboolean
+gpk_updates_manager_is_on_battery (GpkUpdatesManager *manager)
+{
+	GVariant *val = NULL;
+	UpDeviceState state;
+
+	/* the warning level stays at none until the battery is low */
+	if (!manager->proxy_upower)
+		return FALSE;
+
+	val = g_dbus_proxy_get_cached_property (manager->proxy_upower, "State");
+	if (!val)
+		return FALSE;
+	state = g_variant_get_uint32 (val);
+	g_variant_unref (val);
+
+	return state == UP_DEVICE_STATE_DISCHARGING ||
+	       state == UP_DEVICE_STATE_PENDING_DISCHARGE ||
+	       state == UP_DEVICE_STATE_EMPTY;
+}
+
+static gboolean
+gpk_updates_manager_get_pressure (const gchar *resource, gdouble *pressure)
+{
+	gchar *filename = NULL, *contents = NULL;
+	gchar *avg60;
+	gboolean ret = FALSE;
+
+	/* some avg10=0.00 avg60=0.00 avg300=0.00 total=0 */
+	filename = g_build_filename ("/proc/pressure", resource, NULL);
+	if (!g_file_get_contents (filename, &contents, NULL, NULL))
+		goto out;
+
+	avg60 = strstr (contents, "avg60=");
+	if (avg60 == NULL)
+		goto out;
+
+	*pressure = g_ascii_strtod (avg60 + strlen ("avg60="), NULL);
+	ret = TRUE;
+
+out:
+	g_free (contents);
+	g_free (filename);
+
+	return ret;
+}
+
+static gboolean
+gpk_updates_manager_is_loaded (void)
+{
+	const gchar *resources[] = { "cpu", "io", "memory", NULL };
+	gchar *contents = NULL;
+	gdouble pressure, load;
+	gboolean has_pressure = FALSE;
+	guint i;
+
+	for (i = 0; resources[i] != NULL; i++) {
+		if (!gpk_updates_manager_get_pressure (resources[i], &pressure))
+			continue;
+		has_pressure = TRUE;
+		if (pressure >= GPK_UPDATES_MANAGER_BUSY_PRESSURE) {
+			g_debug ("the %s pressure is %.2f%%", resources[i], pressure);
+			return TRUE;
+		}
+	}
+	if (has_pressure)
+		return FALSE;
+
+	/* older kernels, or without PSI */
+	if (!g_file_get_contents ("/proc/loadavg", &contents, NULL, NULL))
+		return FALSE;
+
+	load = g_ascii_strtod (contents, NULL) / g_get_num_processors ();
+	g_free (contents);
+
+	if (load >= GPK_UPDATES_MANAGER_BUSY_LOAD) {
+		g_debug ("the load is %.2f per processor", load);
+		return TRUE;
+	}
+
+	return FALSE;
+}
+
+static gboolean
+gpk_updates_manager_is_busy (GpkUpdatesManager *manager)
+{
+	/* the user is away, the work can not bother anyone */
+	if (manager->session_idle)
+		return FALSE;
+
+	return gpk_updates_manager_is_loaded ();
+}
+
+static gboolean
+gpk_updates_manager_busy_check_cb (gpointer user_data)
+{
+	GpkUpdatesManager *manager = GPK_UPDATES_MANAGER (user_data);
+
+	manager->busy_check_id = 0;
+	gpk_updates_manager_run_pending_work (manager);
+
+	return G_SOURCE_REMOVE;
+}
+
+static void
+gpk_updates_manager_watch_busy (GpkUpdatesManager *manager)
+{
+	/* the load changes without telling, so look again later */
+	if (manager->busy_check_id != 0)
+		return;
+
+	manager->busy_check_id =
+		g_timeout_add_seconds (GPK_UPDATES_MANAGER_BUSY_RECHECK,
+		                       gpk_updates_manager_busy_check_cb,
+		                       manager);
+	g_source_set_name_by_id (manager->busy_check_id,
+	                         "[GpkUpdatesManager] busy check");
+}
+
 static void
 gpk_updates_notififier_launch_update_viewer (GpkUpdatesManager *manager)
 {
@@ -150,32 +322,217 @@ static void
 gpk_updates_manager_auto_download_done (GpkUpdatesManager *manager)
 {
 	g_debug ("Download done.");
+	manager->busy_since = 0;
+	manager->download_failures = 0;
+
+	/* the user already knows that there are updates to install */
+	if (manager->important_notified)
+		return;
+
 	gpk_updates_manager_notify_updates (manager, TRUE);
 }
 
+static gboolean
+gpk_updates_manager_is_allowed (GpkUpdatesManager *manager, GpkUpdatesWork work)
+{
+	/* never check for updates nor download when offline */
+	if (!gpk_updates_manager_is_online (manager)) {
+		g_debug ("could not work due offline");
+		return FALSE;
+	}
+
+	if (work == GPK_UPDATES_WORK_REFRESH) {
+		/* never refresh when the battery is low */
+		if (gpk_updates_manager_get_battery_status (manager) >= UP_DEVICE_LEVEL_LOW) {
+			g_debug ("not getting updates on low power");
+			return FALSE;
+		}
+	} else {
+		/* only download when plugged in */
+		if (gpk_updates_manager_is_on_battery (manager)) {
+			g_debug ("not downloading updates on battery");
+			return FALSE;
+		}
+
+		/* and the rest only when it costs nothing */
+		if (work == GPK_UPDATES_WORK_DOWNLOAD_REST &&
+		    g_network_monitor_get_network_metered (manager->network_monitor)) {
+			g_debug ("not downloading the other updates on a metered network");
+			return FALSE;
+		}
+	}
+
+	return TRUE;
+}
+
+static gboolean
+gpk_updates_manager_can_work (GpkUpdatesManager *manager, GpkUpdatesWork work)
+{
+	gint max_deferral;
+
+	if (!gpk_updates_manager_is_allowed (manager, work))
+		return FALSE;
+
+	/* and wait for an idle computer, but not forever, so the wait is
+	 * only forgotten once the work is done */
+	if (!gpk_updates_manager_is_busy (manager))
+		return TRUE;
+
+	if (manager->busy_since == 0)
+		manager->busy_since = g_get_monotonic_time ();
+
+	max_deferral = g_settings_get_int (gpk_updates_shared_get_settings (manager->shared),
+	                                   GPK_SETTINGS_MAX_BUSY_DEFERRAL);
+	if (g_get_monotonic_time () - manager->busy_since >= (gint64) max_deferral * G_USEC_PER_SEC) {
+		g_debug ("waited too long for an idle computer, working anyway");
+		return TRUE;
+	}
+
+	g_debug ("not working while the computer is busy");
+	gpk_updates_manager_watch_busy (manager);
+	return FALSE;
+}
+
+static void
+gpk_updates_manager_defer_work (GpkUpdatesManager *manager, GpkUpdatesWork work)
+{
+	g_debug ("deferring work 0x%x until the conditions allow it", work);
+	manager->pending_work |= work;
+}
+
+static GpkUpdatesWork
+gpk_updates_manager_get_download_work (GpkUpdatesManager *manager)
+{
+	if (gpk_updates_download_get_important_ready (manager->download))
+		return GPK_UPDATES_WORK_DOWNLOAD_REST;
+
+	return GPK_UPDATES_WORK_DOWNLOAD;
+}
+
+static void
+gpk_updates_manager_download_updates (GpkUpdatesManager *manager)
+{
+	g_debug ("there are updates to download");
+	manager->pending_work &= ~gpk_updates_manager_get_download_work (manager);
+
+	/* continues from the last finished batch */
+	gpk_updates_download_start (manager->download);
+}
+
+static void
+gpk_updates_manager_important_download_done (GpkUpdatesManager *manager)
+{
+	g_debug ("Important updates downloaded.");
+	manager->download_failures = 0;
+
+	/* they can be installed now, without waiting for the rest */
+	manager->important_notified = TRUE;
+	gpk_updates_manager_notify_updates (manager, TRUE);
+
+	if (!gpk_updates_manager_can_work (manager, GPK_UPDATES_WORK_DOWNLOAD_REST)) {
+		gpk_updates_manager_defer_work (manager, GPK_UPDATES_WORK_DOWNLOAD_REST);
+		return;
+	}
+
+	gpk_updates_manager_download_updates (manager);
+}
+
+static void
+gpk_updates_manager_download_progress (GpkUpdatesManager *manager, guint percentage)
+{
+	gpk_updates_dbus_emit_download_progress (manager->dbus, percentage);
+}
+
+static guint
+gpk_updates_manager_get_retry_seconds (guint failures)
+{
+	guint seconds;
+
+	/* back off exponentially, with a random half to not retry in step */
+	seconds = GPK_UPDATES_MANAGER_RETRY_MIN << MIN (failures - 1, 8);
+	seconds = MIN (seconds, GPK_UPDATES_MANAGER_RETRY_MAX);
+
+	return seconds / 2 + g_random_int_range (0, seconds / 2 + 1);
+}
+
+static gboolean
+gpk_updates_manager_download_retry_cb (gpointer user_data)
+{
+	GpkUpdatesManager *manager = GPK_UPDATES_MANAGER (user_data);
+
+	manager->download_retry_id = 0;
+	gpk_updates_manager_run_pending_work (manager);
+
+	return G_SOURCE_REMOVE;
+}
+
+static void
+gpk_updates_manager_download_failed (GpkUpdatesManager *manager)
+{
+	guint seconds;
+
+	/* continue from the failed batch when allowed again */
+	gpk_updates_manager_defer_work (manager, gpk_updates_manager_get_download_work (manager));
+
+	/* the network or the power went away, their events resume it */
+	if (!gpk_updates_manager_is_online (manager) ||
+	    gpk_updates_manager_is_on_battery (manager)) {
+		g_debug ("Download interrupted, waiting for the conditions");
+		return;
+	}
+
+	manager->download_failures++;
+	seconds = gpk_updates_manager_get_retry_seconds (manager->download_failures);
+	g_debug ("Download failed %u times, retrying in %u seconds",
+	         manager->download_failures, seconds);
+
+	if (manager->download_retry_id != 0)
+		g_source_remove (manager->download_retry_id);
+	manager->download_retry_id =
+		g_timeout_add_seconds (seconds,
+		                       gpk_updates_manager_download_retry_cb,
+		                       manager);
+	g_source_set_name_by_id (manager->download_retry_id,
+	                         "[GpkUpdatesManager] download retry");
+}
+
 static void
 gpk_updates_manager_checker_has_updates (GpkUpdatesManager *manager)
 {
-	UpDeviceLevel battery_level = UP_DEVICE_LEVEL_UNKNOWN;
+	GpkUpdatesWork download_work;
 	gboolean auto_download = FALSE;
-	gchar **package_ids;
 
-	battery_level = gpk_updates_manager_get_battery_status (manager);
 	auto_download = g_settings_get_boolean (gpk_updates_shared_get_settings (manager->shared),
 	                                        GPK_SETTINGS_AUTO_DOWNLOAD_UPDATES);
 
 	/* should we auto-download the updates? */
-	if (auto_download && battery_level >= UP_DEVICE_LEVEL_DISCHARGING) {
-		g_debug ("there are updates to download");
+	if (!auto_download) {
+		g_debug ("there are updates to notify");
+		gpk_updates_manager_notify_updates (manager, FALSE);
+		return;
+	}
+
+	gpk_updates_download_set_updates (manager->download,
+	                                  gpk_updates_checker_get_update_packages (manager->checker));
+	manager->pending_work &= ~(GPK_UPDATES_WORK_DOWNLOAD | GPK_UPDATES_WORK_DOWNLOAD_REST);
+	manager->important_notified = FALSE;
 
-		package_ids = gpk_updates_checker_get_update_packages_ids (manager->checker);
-		gpk_updates_download_auto_download_updates (manager->download, package_ids);
-		g_strfreev (package_ids);
+	/* a new list, so no need to wait for the retry of the old one */
+	manager->download_failures = 0;
+	if (manager->download_retry_id != 0) {
+		g_source_remove (manager->download_retry_id);
+		manager->download_retry_id = 0;
 	}
-	else {
-		g_debug ("there are updates to notify");
+
+	/* tell about them now, and download as soon as possible */
+	download_work = gpk_updates_manager_get_download_work (manager);
+	if (!gpk_updates_manager_can_work (manager, download_work)) {
+		gpk_updates_manager_defer_work (manager, download_work);
 		gpk_updates_manager_notify_updates (manager, FALSE);
+		return;
 	}
+
+	gpk_updates_manager_download_updates (manager);
 }
 
 static void
@@ -184,63 +541,163 @@ gpk_updates_manager_refresh_cache_done (GpkUpdatesManager *manager)
 	gpk_updates_checker_check_for_updates (manager->checker);
 }
 
-static void
-gpk_updates_manager_generic_error (GpkUpdatesManager *manager)
-{
-	/* TODO: Do something non-generic. */
-	g_debug ("generic error");
-}
-
 static void
 gpk_updates_manager_check_updates (GpkUpdatesManager *manager)
 {
-	/* never refresh when the battery is low */
-	if (gpk_updates_manager_get_battery_status (manager) >= UP_DEVICE_LEVEL_LOW) {
-		g_debug ("not getting updates on low power");
-		return;
-	}
-
-	/* never check for updates when offline */
-	if (!gpk_updates_manager_is_online(manager)) {
-		g_debug ("coul not getting updates due offline");
+	/* wait for the network and the power */
+	if (!gpk_updates_manager_can_work (manager, GPK_UPDATES_WORK_REFRESH)) {
+		gpk_updates_manager_defer_work (manager, GPK_UPDATES_WORK_REFRESH);
 		return;
 	}
+	manager->pending_work &= ~GPK_UPDATES_WORK_REFRESH;
 
 	/* check if need refresh cache. */
 	gpk_updates_refresh_update_cache (manager->refresh);
 }
 
-static gboolean
-gpk_updates_manager_check_hourly_cb (gpointer data)
+static guint
+gpk_updates_manager_get_host_hash (void)
 {
-	GpkUpdatesManager *manager = GPK_UPDATES_MANAGER (data);
+	gchar *machine_id = NULL;
+	guint hash;
+
+	/* stable for each machine, so they do not all wake up at once */
+	if (g_file_get_contents ("/etc/machine-id", &machine_id, NULL, NULL)) {
+		hash = g_str_hash (g_strstrip (machine_id));
+		g_free (machine_id);
+		return hash;
+	}
 
-	g_debug ("Hourly updates check");
-	gpk_updates_manager_check_updates (manager);
+	return g_str_hash (g_get_host_name ());
+}
 
-	return G_SOURCE_CONTINUE;
+static guint
+gpk_updates_manager_add_jitter (GpkUpdatesManager *manager, guint seconds)
+{
+	/* spread the machines over a tenth of the interval */
+	return seconds + manager->host_hash % (seconds / 10 + 1);
 }
 
+static gboolean gpk_updates_manager_check_cb (gpointer data);
+
 static void
 gpk_updates_manager_stop_updates_check (GpkUpdatesManager *manager)
 {
-	if (manager->check_hourly_id == 0)
+	if (manager->check_id == 0)
 		return;
 
-	g_source_remove (manager->check_hourly_id);
-	manager->check_hourly_id = 0;
+	g_source_remove (manager->check_id);
+	manager->check_id = 0;
 }
 
 static void
-gpk_updates_manager_restart_updates_check (GpkUpdatesManager *manager)
+gpk_updates_manager_schedule_check (GpkUpdatesManager *manager, guint seconds)
 {
 	gpk_updates_manager_stop_updates_check (manager);
+
+	g_debug ("Next updates check in %u seconds", seconds);
+	manager->check_id = g_timeout_add_seconds (seconds,
+	                                           gpk_updates_manager_check_cb,
+	                                           manager);
+	g_source_set_name_by_id (manager->check_id,
+	                         "[GpkUpdatesManager] scheduled check");
+}
+
+static void
+gpk_updates_manager_check_done (GpkUpdatesManager *manager)
+{
+	guint seconds;
+
+	manager->check_failures = 0;
+	manager->busy_since = 0;
+
+	/* wake up when the next refresh is due */
+	seconds = gpk_updates_refresh_get_seconds_to_refresh (manager->refresh);
+	seconds = CLAMP (seconds, GPK_UPDATES_MANAGER_CHECK_MIN, GPK_UPDATES_MANAGER_CHECK_MAX);
+	gpk_updates_manager_schedule_check (manager, gpk_updates_manager_add_jitter (manager, seconds));
+}
+
+static void
+gpk_updates_manager_check_failed (GpkUpdatesManager *manager)
+{
+	guint seconds;
+
+	/* the network or the power went away, wait for them to come back */
+	if (!gpk_updates_manager_is_online (manager) ||
+	    gpk_updates_manager_get_battery_status (manager) >= UP_DEVICE_LEVEL_LOW) {
+		g_debug ("Updates check interrupted, waiting for the conditions");
+		gpk_updates_manager_defer_work (manager, GPK_UPDATES_WORK_REFRESH);
+		return;
+	}
+
+	manager->check_failures++;
+	seconds = gpk_updates_manager_get_retry_seconds (manager->check_failures);
+
+	g_debug ("Updates check failed %u times", manager->check_failures);
+	gpk_updates_manager_schedule_check (manager, seconds);
+}
+
+static void
+gpk_updates_manager_check_now (GpkUpdatesManager *manager)
+{
+	/* in case nothing answers, the next one is already scheduled */
+	gpk_updates_manager_schedule_check (manager,
+	                                    gpk_updates_manager_add_jitter (manager, GPK_UPDATES_MANAGER_CHECK_MAX));
+
 	gpk_updates_manager_check_updates (manager);
+}
+
+static gboolean
+gpk_updates_manager_check_cb (gpointer data)
+{
+	GpkUpdatesManager *manager = GPK_UPDATES_MANAGER (data);
+
+	g_debug ("Scheduled updates check");
+	manager->check_id = 0;
+	gpk_updates_manager_check_now (manager);
+
+	return G_SOURCE_REMOVE;
+}
+
+static void
+gpk_updates_manager_run_pending_work (GpkUpdatesManager *manager)
+{
+	GpkUpdatesWork download_work;
+
+	/* the checks are not started yet */
+	if (manager->check_startup_id != 0)
+		return;
+
+	/* pause the download, it continues when allowed again, but not for
+	 * the load, that is mostly its own */
+	download_work = gpk_updates_manager_get_download_work (manager);
+	if (gpk_updates_download_is_running (manager->download) &&
+	    !gpk_updates_manager_is_allowed (manager, download_work)) {
+		gpk_updates_download_pause (manager->download);
+		gpk_updates_manager_defer_work (manager, download_work);
+	}
+
+	/* only a check deferred by the conditions wakes up early, the
+	 * backoff of the failed ones is kept */
+	if ((manager->pending_work & GPK_UPDATES_WORK_REFRESH) &&
+	    gpk_updates_manager_can_work (manager, GPK_UPDATES_WORK_REFRESH)) {
+		g_debug ("Conditions changed, checking for updates soon");
+		manager->pending_work &= ~GPK_UPDATES_WORK_REFRESH;
+
+		/* the deferred download is kept, in case the check finds nothing new,
+		 * and let the connection settle, and not with all the machines */
+		gpk_updates_manager_schedule_check (manager,
+		                                    gpk_updates_manager_add_jitter (manager, GPK_UPDATES_MANAGER_WAKE_DELAY));
+		return;
+	}
 
-	manager->check_hourly_id
-		= g_timeout_add_seconds (SECONDS_IN_AN_HOUR,
-		                         gpk_updates_manager_check_hourly_cb,
-		                         manager);
+	/* a failed download waits for its retry */
+	if (manager->download_retry_id == 0 &&
+	    (manager->pending_work & download_work) &&
+	    gpk_updates_manager_can_work (manager, download_work)) {
+		g_debug ("Conditions changed, downloading the updates");
+		gpk_updates_manager_download_updates (manager);
+	}
 }
 
 static gboolean
@@ -250,15 +707,56 @@ gpk_updates_manager_check_updates_on_startup_cb (gpointer user_data)
 
 	g_return_val_if_fail (GPK_IS_UPDATES_MANAGER (manager), G_SOURCE_REMOVE);
 
-	g_debug ("First hourly updates check");
-	gpk_updates_manager_restart_updates_check (manager);
-
+	g_debug ("First updates check");
 	manager->check_startup_id = 0;
 
+	gpk_updates_manager_check_now (manager);
+
 	return G_SOURCE_REMOVE;
 }
 
 
+/**
+ * Run the deferred work as soon as the conditions allow it.
+ */
+
+static void
+gpk_updates_manager_network_changed_cb (GNetworkMonitor   *monitor,
+                                        gboolean           available,
+                                        GpkUpdatesManager *manager)
+{
+	gpk_updates_manager_run_pending_work (manager);
+}
+
+static void
+gpk_updates_manager_upower_properties_changed_cb (GDBusProxy        *proxy,
+                                                  GVariant          *changed_properties,
+                                                  GStrv              invalidated_properties,
+                                                  GpkUpdatesManager *manager)
+{
+	gpk_updates_manager_run_pending_work (manager);
+}
+
+static void
+gpk_updates_manager_presence_signal_cb (GDBusProxy        *proxy,
+                                        const gchar       *sender_name,
+                                        const gchar       *signal_name,
+                                        GVariant          *parameters,
+                                        GpkUpdatesManager *manager)
+{
+	guint32 status = 0;
+
+	if (g_strcmp0 (signal_name, "StatusChanged") != 0)
+		return;
+
+	g_variant_get (parameters, "(u)", &status);
+	manager->session_idle = (status == GPK_UPDATES_MANAGER_PRESENCE_IDLE);
+	g_debug ("the session is %s", manager->session_idle ? "idle" : "active");
+
+	gpk_updates_manager_run_pending_work (manager);
+}
+
+
 /**
  * React when updater is launched or closed.
  */
@@ -320,6 +818,9 @@ gpk_updates_manager_dispose (GObject *object)
 
 	g_debug ("Stopping updates manager");
 
+	if (manager->network_monitor != NULL)
+		g_signal_handlers_disconnect_by_data (manager->network_monitor, manager);
+
 	gpk_updates_manager_stop_updates_check (manager);
 
 	if (manager->check_startup_id != 0) {
@@ -332,11 +833,26 @@ gpk_updates_manager_dispose (GObject *object)
 		manager->dbus_watch_id = 0;
 	}
 
+	if (manager->busy_check_id != 0) {
+		g_source_remove (manager->busy_check_id);
+		manager->busy_check_id = 0;
+	}
+
+	if (manager->download_retry_id != 0) {
+		g_source_remove (manager->download_retry_id);
+		manager->download_retry_id = 0;
+	}
+
+	if (manager->proxy_presence != NULL)
+		g_signal_handlers_disconnect_by_data (manager->proxy_presence, manager);
+	g_clear_object (&manager->proxy_presence);
+
 	g_clear_object (&manager->proxy_upower);
 
 	g_clear_object (&manager->notification);
 
 	g_clear_object (&manager->refresh);
+	g_clear_object (&manager->dbus);
 	g_clear_object (&manager->checker);
 	g_clear_object (&manager->shared);
 	g_clear_object (&manager->download);
@@ -357,6 +873,7 @@ gpk_updates_manager_class_init (GpkUpdatesManagerClass *klass)
 static void
 gpk_updates_manager_init (GpkUpdatesManager *manager)
 {
+	GVariant *val = NULL;
 	GError *error = NULL;
 
 	g_debug ("Starting updates manager");
@@ -371,23 +888,33 @@ gpk_updates_manager_init (GpkUpdatesManager *manager)
 	g_signal_connect_swapped (manager->refresh, "valid-cache",
 	                          G_CALLBACK (gpk_updates_manager_refresh_cache_done), manager);
 	g_signal_connect_swapped (manager->refresh, "error-refresh",
-	                          G_CALLBACK (gpk_updates_manager_generic_error), manager);
+	                          G_CALLBACK (gpk_updates_manager_check_failed), manager);
 
 	/* The check for updates task */
 
 	manager->checker = gpk_updates_checker_new ();
 	g_signal_connect_swapped (manager->checker, "has-updates",
 	                          G_CALLBACK (gpk_updates_manager_checker_has_updates), manager);
+	g_signal_connect_swapped (manager->checker, "check-finished",
+	                          G_CALLBACK (gpk_updates_manager_check_done), manager);
 	g_signal_connect_swapped (manager->checker, "error-checking",
-	                          G_CALLBACK (gpk_updates_manager_generic_error), manager);
+	                          G_CALLBACK (gpk_updates_manager_check_failed), manager);
+
+	/* share the updates found with the update viewer */
+
+	manager->dbus = gpk_updates_dbus_new (manager->checker);
 
 	/* the update download task */
 
 	manager->download = gpk_updates_download_new ();
 	g_signal_connect_swapped (manager->download, "download-done",
 	                          G_CALLBACK (gpk_updates_manager_auto_download_done), manager);
+	g_signal_connect_swapped (manager->download, "important-done",
+	                          G_CALLBACK (gpk_updates_manager_important_download_done), manager);
+	g_signal_connect_swapped (manager->download, "download-progress",
+	                          G_CALLBACK (gpk_updates_manager_download_progress), manager);
 	g_signal_connect_swapped (manager->download, "error-downloading",
-	                          G_CALLBACK (gpk_updates_manager_generic_error), manager);
+	                          G_CALLBACK (gpk_updates_manager_download_failed), manager);
 
 	/* the notification manager */
 
@@ -402,6 +929,8 @@ gpk_updates_manager_init (GpkUpdatesManager *manager)
 	/* we have to consider the network connection before looking for updates */
 
 	manager->network_monitor = g_network_monitor_get_default ();
+	g_signal_connect (manager->network_monitor, "network-changed",
+	                  G_CALLBACK (gpk_updates_manager_network_changed_cb), manager);
 
 	/* connect to UPower to get the system power state */
 	manager->proxy_upower =
@@ -415,12 +944,39 @@ gpk_updates_manager_init (GpkUpdatesManager *manager)
 		                               &error);
 	if (!manager->proxy_upower) {
 		g_warning ("failed to connect to upower: %s", error->message);
-		g_error_free (error);
+		g_clear_error (&error);
+	} else {
+		g_signal_connect (manager->proxy_upower, "g-properties-changed",
+		                  G_CALLBACK (gpk_updates_manager_upower_properties_changed_cb), manager);
+	}
+
+	/* and to the session, to not bother the user with the heavy work */
+	manager->proxy_presence =
+		g_dbus_proxy_new_for_bus_sync (G_BUS_TYPE_SESSION,
+		                               G_DBUS_PROXY_FLAGS_DO_NOT_AUTO_START,
+		                               NULL,
+		                               "org.gnome.SessionManager",
+		                               "/org/gnome/SessionManager/Presence",
+		                               "org.gnome.SessionManager.Presence",
+		                               NULL,
+		                               &error);
+	if (!manager->proxy_presence) {
+		g_warning ("failed to connect to the session presence: %s", error->message);
+		g_clear_error (&error);
+	} else {
+		val = g_dbus_proxy_get_cached_property (manager->proxy_presence, "status");
+		if (val != NULL) {
+			manager->session_idle = (g_variant_get_uint32 (val) == GPK_UPDATES_MANAGER_PRESENCE_IDLE);
+			g_variant_unref (val);
+		}
+		g_signal_connect (manager->proxy_presence, "g-signal",
+		                  G_CALLBACK (gpk_updates_manager_presence_signal_cb), manager);
 	}
 
-	/* do a first check 60 seconds after login, and then every hour */
+	/* do a first check about 60 seconds after login, and then when due */
+	manager->host_hash = gpk_updates_manager_get_host_hash ();
 	manager->check_startup_id =
-		g_timeout_add_seconds (60,
+		g_timeout_add_seconds (gpk_updates_manager_add_jitter (manager, 60),
 		                       gpk_updates_manager_check_updates_on_startup_cb,
 		                       manager);
 	g_source_set_name_by_id (manager->check_startup_id,
@@ -31,6 +31,8 @@ struct _GpkUpdatesRefresh
 	GObject			_parent;
 
 	GpkUpdatesShared	*shared;
+
+	gint64			 refresh_due;
 };
 
 enum {
@@ -43,6 +45,12 @@ static guint signals [LAST_SIGNAL] = { 0 };
 
 G_DEFINE_TYPE (GpkUpdatesRefresh, gpk_updates_refresh, G_TYPE_OBJECT)
 
+static void
+gpk_updates_refresh_set_refresh_due (GpkUpdatesRefresh *refresh, guint seconds)
+{
+	refresh->refresh_due = g_get_monotonic_time () + (gint64) seconds * G_USEC_PER_SEC;
+}
+
 /*
  * Refresh cache.
  */
@@ -87,6 +95,9 @@ gpk_updates_refresh_pk_refresh_cache_finished_cb (GObject           *object,
 	}
 
 	g_debug ("Cache was updated.");
+	gpk_updates_refresh_set_refresh_due (refresh,
+	                                     g_settings_get_int (gpk_updates_shared_get_settings (refresh->shared),
+	                                                         GPK_SETTINGS_FREQUENCY_GET_UPDATES));
 	g_signal_emit (refresh, signals [VALID_CACHE], 0);
 }
 
@@ -136,6 +147,7 @@ gpk_updates_refresh_pk_get_time_since_refresh_cache_cb (GObject           *objec
 
 	if (seconds < threshold) {
 		g_debug ("not refresh before timeout, thresh=%u, now=%u", threshold, seconds);
+		gpk_updates_refresh_set_refresh_due (refresh, threshold - seconds);
 		g_signal_emit (refresh, signals [VALID_CACHE], 0);
 		return;
 	}
@@ -183,6 +195,19 @@ gpk_updates_refresh_update_cache (GpkUpdatesRefresh *refresh)
 	gpk_updates_refresh_pk_check_refresh_cache (refresh);
 }
 
+guint
+gpk_updates_refresh_get_seconds_to_refresh (GpkUpdatesRefresh *refresh)
+{
+	gint64 now;
+
+	/* unknown until the first check */
+	now = g_get_monotonic_time ();
+	if (refresh->refresh_due <= now)
+		return 0;
+
+	return (guint) ((refresh->refresh_due - now) / G_USEC_PER_SEC);
+}
+
 
 /**
  *  GpkUpdatesRefresh:
@@ -30,6 +30,8 @@ G_DECLARE_FINAL_TYPE (GpkUpdatesRefresh, gpk_updates_refresh, GPK, UPDATES_REFRE
 
 void gpk_updates_refresh_update_cache (GpkUpdatesRefresh *refresh);
 
+guint gpk_updates_refresh_get_seconds_to_refresh (GpkUpdatesRefresh *refresh);
+
 GpkUpdatesRefresh *gpk_updates_refresh_new (void);
 
 G_END_DECLS
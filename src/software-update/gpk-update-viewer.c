@@ -28,6 +28,7 @@
 #include <gtk/gtk.h>
 #include <gtk/gtk.h>
 #include <locale.h>
+#include <string.h>
 #include <packagekit-glib2/packagekit.h>
 
 #include <common/gpk-common.h>
@@ -37,6 +38,7 @@
 #include <common/gpk-gnome.h>
 #include <common/gpk-session.h>
 #include <common/gpk-task.h>
+#include <common/gpk-update-snapshot.h>
 #include <common/gpk-debug.h>
 
 #include "gpk-cell-renderer-info.h"
@@ -45,22 +47,49 @@
 
 #define SECONDS_IN_AN_MINUTE (60)
 #define SECONDS_IN_AN_HOUR (60 * 60)
+#define SECONDS_IN_A_DAY (60 * 60 * 24)
 
 #define GPK_UPDATE_VIEWER_AUTO_QUIT_TIMEOUT	10 /* seconds */
 #define GPK_UPDATE_VIEWER_AUTO_RESTART_TIMEOUT	60 /* seconds */
 #define GPK_UPDATE_VIEWER_MOBILE_SMALL_SIZE	512*1024 /* bytes */
+#define GPK_UPDATE_VIEWER_PROGRESS_INTERVAL	33 /* ms, about 30 frames per second */
+#define GPK_UPDATE_VIEWER_DETAILS_CHUNK		50 /* packages */
+#define GPK_UPDATE_VIEWER_SERVICE_TIMEOUT	2000 /* ms */
 
 static	gboolean		 ignore_updates_changed = FALSE;
 static	guint			 size_selected = 0;
+static	guint			 download_selected = 0;
+static	guint			 download_rate = 0;
 static	guint			 number_selected = 0;
 static	PkRestartEnum		 restart_worst = 0;
 static	gboolean		 all_prepared = FALSE;
+static	guint			 restart_selected[PK_RESTART_ENUM_LAST] = { 0 };
+static	guint			 unprepared_selected = 0;
 static	GpkSession		*session = NULL;
 static	GCancellable		*cancellable = NULL;
 static	GSettings		*settings = NULL;
 static	GPtrArray		*update_array = NULL;
 static	GtkBuilder		*builder = NULL;
 static	GtkTreeStore		*array_store_updates = NULL;
+static	GHashTable		*array_store_rows = NULL;
+static	GtkTreeRowReference	*array_store_headers[PK_INFO_ENUM_LAST] = { NULL };
+static	GPtrArray		*progress_queue = NULL;
+static	GHashTable		*progress_pending = NULL;
+static	guint			 progress_flush_id = 0;
+static	GCancellable		*details_cancellable = NULL;
+static	GPtrArray		*details_queue = NULL;
+static	GHashTable		*details_pending = NULL;
+static	guint			 details_queue_pos = 0;
+static	gboolean		 details_error_shown = FALSE;
+static	gboolean		 details_complete = FALSE;
+static	gboolean		 update_list_stale = FALSE;
+static	GPtrArray		*snapshot_items = NULL;
+static	GHashTable		*snapshot_index = NULL;
+static	GDBusConnection		*service_connection = NULL;
+static	guint			 service_signal_id = 0;
+static	guint			 service_watch_id = 0;
+static	gboolean		 service_available = FALSE;
+static	PkNetworkEnum		 network_state = PK_NETWORK_ENUM_UNKNOWN;
 static	GtkTextBuffer		*text_buffer = NULL;
 static	PkControl		*control = NULL;
 static	PkRestartEnum		 restart_update = 0;
@@ -69,8 +98,9 @@ static	GtkWidget		*info_mobile = NULL;
 static	GtkWidget		*info_mobile_label = NULL;
 static	GtkApplication		*application = NULL;
 static	PkBitfield		 roles = 0;
-guint				 last_resfreh_ago;
-guint				 last_refresh_id;
+static	gint64			 last_refresh_time = 0;
+static	gboolean		 last_refresh_shown = FALSE;
+static	guint			 last_refresh_id = 0;
 
 enum {
 	GPK_UPDATES_COLUMN_TEXT,
@@ -83,6 +113,7 @@ enum {
 	GPK_UPDATES_COLUMN_PREPARED,
 	GPK_UPDATES_COLUMN_SIZE,
 	GPK_UPDATES_COLUMN_SIZE_DISPLAY,
+	GPK_UPDATES_COLUMN_DOWNLOAD_SIZE,
 	GPK_UPDATES_COLUMN_STATUS,
 	GPK_UPDATES_COLUMN_DETAILS_OBJ,
 	GPK_UPDATES_COLUMN_UPDATE_DETAIL_OBJ,
@@ -90,11 +121,33 @@ enum {
 	GPK_UPDATES_COLUMN_LAST
 };
 
+typedef struct {
+	gchar		*package_id;
+	gchar		*summary;
+	PkInfoEnum	 info;
+	PkRoleEnum	 role;
+	gboolean	 has_package;
+	PkInfoEnum	 status;
+	gboolean	 finished;
+	gint		 percentage;
+} GpkUpdateViewerProgress;
+
+typedef struct {
+	GCancellable	*cancellable;
+	guint		 pending;
+} GpkUpdateViewerDetailsChunk;
+
 static void gpk_update_viewer_empty_stack_message (const gchar *title, const gchar *message, gboolean updated);
 
 static void gpk_update_viewer_get_updates (void);
+static void gpk_update_viewer_get_shared_updates (void);
 static void gpk_update_viewer_refresh_cache (void);
 static void gpk_updates_viewer_validate_cache (void);
+static void gpk_updates_viewer_refresh_cache_done (void);
+static void gpk_update_viewer_details_fetch_next (void);
+static void gpk_update_viewer_clear_updates (void);
+static void gpk_update_viewer_progress_flush (void);
+static void gpk_update_viewer_snapshot_save (void);
 
 static gboolean
 _g_strzero (const gchar *text)
@@ -114,6 +167,8 @@ gpk_update_viewer_quit (void)
 {
 	/* are we in a transaction */
 	g_cancellable_cancel (cancellable);
+	if (details_cancellable != NULL)
+		g_cancellable_cancel (details_cancellable);
 	g_application_release (G_APPLICATION (application));
 }
 
@@ -366,6 +421,18 @@ out:
 	return selected;
 }
 
+/**
+ * gpk_update_viewer_download_rate_save:
+ **/
+static void
+gpk_update_viewer_download_rate_save (void)
+{
+	if (download_rate == g_settings_get_uint (settings, GPK_SETTINGS_DOWNLOAD_RATE))
+		return;
+	g_debug ("download rate is now %u bytes per second", download_rate);
+	g_settings_set_uint (settings, GPK_SETTINGS_DOWNLOAD_RATE, download_rate);
+}
+
 /**
  * gpk_update_viewer_update_packages_cb:
  **/
@@ -383,6 +450,12 @@ gpk_update_viewer_update_packages_cb (PkTask *_task, GAsyncResult *res, gpointer
 	GtkTreeView *treeview;
 	GtkTreeModel *model;
 
+	/* show the final state of every package */
+	gpk_update_viewer_progress_flush ();
+
+	/* so the next download can be estimated */
+	gpk_update_viewer_download_rate_save ();
+
 	/* get the results */
 	results = pk_task_generic_finish (task, res, &error);
 	if (results == NULL) {
@@ -488,52 +561,44 @@ out:
 
 
 /**
- * gpk_update_viewer_find_iter_model_cb:
+ * gpk_update_viewer_package_id_to_key:
+ *
+ * The rows are matched on the package name and arch, ignoring the version.
  **/
-static gboolean
-gpk_update_viewer_find_iter_model_cb (GtkTreeModel *model,
-                                      GtkTreePath  *path,
-                                      GtkTreeIter  *iter,
-                                      const gchar  *package_id)
-{
-	gchar **split_a = NULL, **split_b = NULL;
-	gchar *package_id_tmp = NULL;
-	gchar *package_name_a = NULL, *package_name_b = NULL;
-	gchar *arch_a = NULL, *arch_b = NULL;
-	GtkTreePath **_path = NULL;
-	gboolean ret = FALSE;
-
-	gtk_tree_model_get (model, iter,
-	                    GPK_UPDATES_COLUMN_ID, &package_id_tmp,
-	                   - 1);
+static gchar *
+gpk_update_viewer_package_id_to_key (const gchar *package_id)
+{
+	gchar **split = NULL;
+	gchar *key = NULL;
 
-	// maybe headers
-	if (package_id_tmp == NULL)
-		goto out;
+	split = pk_package_id_split (package_id);
+	if (split == NULL)
+		return NULL;
 
-	split_a = pk_package_id_split (package_id);
-	package_name_a = split_a[PK_PACKAGE_ID_NAME];
-	arch_a = split_a[PK_PACKAGE_ID_ARCH];
+	key = g_strdup_printf ("%s;%s", split[PK_PACKAGE_ID_NAME], split[PK_PACKAGE_ID_ARCH]);
+	g_strfreev (split);
 
-	split_b = pk_package_id_split (package_id_tmp);
-	package_name_b = split_b[PK_PACKAGE_ID_NAME];
-	arch_b = split_b[PK_PACKAGE_ID_ARCH];
+	return key;
+}
 
-	/* match on the package name and arch but ignore version */
-	if ((g_strcmp0 (package_name_a, package_name_b) == 0) &&
-	    (g_strcmp0 (arch_a, arch_b) == 0))
-	{
-		_path = (GtkTreePath **) g_object_get_data (G_OBJECT(model), "_path");
-		*_path = gtk_tree_path_copy (path);
-		ret = TRUE;
-	}
+/**
+ * gpk_update_viewer_model_add_row:
+ *
+ * Index a package row, so that it can be found without walking the model.
+ **/
+static void
+gpk_update_viewer_model_add_row (GtkTreeModel *model, GtkTreeIter *iter, const gchar *package_id)
+{
+	GtkTreePath *path = NULL;
+	gchar *key = NULL;
 
-	g_free (package_id_tmp);
-	g_strfreev (split_a);
-	g_strfreev (split_b);
+	key = gpk_update_viewer_package_id_to_key (package_id);
+	if (key == NULL)
+		return;
 
-out:
-	return ret;
+	path = gtk_tree_model_get_path (model, iter);
+	g_hash_table_replace (array_store_rows, key, gtk_tree_row_reference_new (model, path));
+	gtk_tree_path_free (path);
 }
 
 /**
@@ -542,12 +607,96 @@ out:
 static GtkTreePath *
 gpk_update_viewer_model_get_path (GtkTreeModel *model, const gchar *package_id)
 {
-	GtkTreePath *path = NULL;
+	GtkTreeRowReference *row = NULL;
+	gchar *key = NULL;
+
 	g_return_val_if_fail (package_id != NULL, NULL);
-	g_object_set_data (G_OBJECT(model), "_path", (gpointer) &path);
-	gtk_tree_model_foreach (model, (GtkTreeModelForeachFunc) gpk_update_viewer_find_iter_model_cb, (gpointer) package_id);
-	g_object_steal_data (G_OBJECT(model), "_path");
-	return path;
+
+	key = gpk_update_viewer_package_id_to_key (package_id);
+	if (key == NULL)
+		return NULL;
+
+	row = g_hash_table_lookup (array_store_rows, key);
+	g_free (key);
+
+	if (row == NULL || !gtk_tree_row_reference_valid (row))
+		return NULL;
+
+	return gtk_tree_row_reference_get_path (row);
+}
+
+/**
+ * gpk_update_viewer_selection_account:
+ *
+ * Adds or removes the contribution of a row to the selection totals, which
+ * is done around any change of the selection, size, restart or prepared
+ * state of a package.
+ **/
+static void
+gpk_update_viewer_selection_account (GtkTreeModel *model, GtkTreeIter *iter, gboolean add)
+{
+	gboolean selected, prepared;
+	PkRestartEnum restart;
+	guint size, download_size;
+	gchar *package_id = NULL;
+
+	gtk_tree_model_get (model, iter,
+	                    GPK_UPDATES_COLUMN_SELECT, &selected,
+	                    GPK_UPDATES_COLUMN_RESTART, &restart,
+	                    GPK_UPDATES_COLUMN_PREPARED, &prepared,
+	                    GPK_UPDATES_COLUMN_SIZE, &size,
+	                    GPK_UPDATES_COLUMN_DOWNLOAD_SIZE, &download_size,
+	                    GPK_UPDATES_COLUMN_ID, &package_id,
+	                    -1);
+	if (!selected || package_id == NULL)
+		goto out;
+	if (restart >= PK_RESTART_ENUM_LAST)
+		restart = PK_RESTART_ENUM_UNKNOWN;
+
+	if (add) {
+		size_selected += size;
+		number_selected++;
+		restart_selected[restart]++;
+		if (!prepared) {
+			download_selected += download_size;
+			unprepared_selected++;
+		}
+	} else {
+		size_selected -= size;
+		number_selected--;
+		restart_selected[restart]--;
+		if (!prepared) {
+			download_selected -= download_size;
+			unprepared_selected--;
+		}
+	}
+out:
+	g_free (package_id);
+}
+
+/**
+ * gpk_update_viewer_selection_reset:
+ **/
+static void
+gpk_update_viewer_selection_reset (void)
+{
+	size_selected = 0;
+	download_selected = 0;
+	number_selected = 0;
+	memset (restart_selected, 0, sizeof (restart_selected));
+	unprepared_selected = 0;
+}
+
+/**
+ * gpk_update_viewer_set_selected:
+ **/
+static void
+gpk_update_viewer_set_selected (GtkTreeModel *model, GtkTreeIter *iter, gboolean selected)
+{
+	gpk_update_viewer_selection_account (model, iter, FALSE);
+	gtk_tree_store_set (GTK_TREE_STORE(model), iter,
+			    GPK_UPDATES_COLUMN_SELECT, selected, -1);
+	gpk_update_viewer_selection_account (model, iter, TRUE);
 }
 
 /**
@@ -589,27 +738,34 @@ gpk_update_view_get_info_headers (PkInfoEnum info)
 	return text;
 }
 
+/**
+ * gpk_update_viewer_clear_headers:
+ **/
+static void
+gpk_update_viewer_clear_headers (void)
+{
+	guint i;
+
+	for (i = 0; i < PK_INFO_ENUM_LAST; i++) {
+		if (array_store_headers[i] == NULL)
+			continue;
+		gtk_tree_row_reference_free (array_store_headers[i]);
+		array_store_headers[i] = NULL;
+	}
+}
+
 /**
  * gpk_update_viewer_get_parent_for_info:
  **/
 static void
 gpk_update_viewer_get_parent_for_info (PkInfoEnum info, GtkTreeIter *parent)
 {
-	gboolean is_package;
-	gboolean ret = FALSE;
-	gboolean valid;
-	gchar *package_id_tmp;
 	gchar *title;
 	GtkTreeIter iter;
 	GtkTreeModel *model;
-	GtkTreeView *treeview;
-	PkInfoEnum info_tmp;
-
-	treeview = GTK_TREE_VIEW(gtk_builder_get_object (builder, "treeview_updates"));
-	model = gtk_tree_view_get_model (treeview);
+	GtkTreePath *path;
 
-	/* get the first iter in the array */
-	valid = gtk_tree_model_get_iter_first (model, &iter);
+	model = GTK_TREE_MODEL (array_store_updates);
 
 	/* smush some update states together */
 	switch (info) {
@@ -620,46 +776,302 @@ gpk_update_viewer_get_parent_for_info (PkInfoEnum info, GtkTreeIter *parent)
 	default:
 		break;
 	}
+	if (info >= PK_INFO_ENUM_LAST)
+		info = PK_INFO_ENUM_UNKNOWN;
+
+	/* right section already added? */
+	if (array_store_headers[info] != NULL) {
+		path = gtk_tree_row_reference_get_path (array_store_headers[info]);
+		if (path != NULL) {
+			gtk_tree_model_get_iter (model, parent, path);
+			gtk_tree_path_free (path);
+			return;
+		}
+		gtk_tree_row_reference_free (array_store_headers[info]);
+		array_store_headers[info] = NULL;
+	}
 
-	/* find out how many we should update */
-	while (valid) {
-		gtk_tree_model_get (model, &iter,
-				    GPK_UPDATES_COLUMN_INFO, &info_tmp,
-				    GPK_UPDATES_COLUMN_ID, &package_id_tmp,
-				    -1);
-		is_package = package_id_tmp != NULL;
-		g_free (package_id_tmp);
+	/* create */
+	title = g_strdup_printf ("<b>%s</b>",
+				 gpk_update_view_get_info_headers (info));
+	gtk_tree_store_append (array_store_updates, &iter, NULL);
+	gtk_tree_store_set (array_store_updates, &iter,
+			    GPK_UPDATES_COLUMN_TEXT, title,
+			    GPK_UPDATES_COLUMN_ID, NULL,
+			    GPK_UPDATES_COLUMN_INFO, info,
+			    GPK_UPDATES_COLUMN_SELECT, TRUE,
+			    GPK_UPDATES_COLUMN_VISIBLE, FALSE,
+			    GPK_UPDATES_COLUMN_CLICKABLE, FALSE,
+			    GPK_UPDATES_COLUMN_RESTART, PK_RESTART_ENUM_NONE,
+			    GPK_UPDATES_COLUMN_STATUS, PK_INFO_ENUM_UNKNOWN,
+			    GPK_UPDATES_COLUMN_SIZE, 0,
+			    GPK_UPDATES_COLUMN_SIZE_DISPLAY, 0,
+			    GPK_UPDATES_COLUMN_DOWNLOAD_SIZE, 0,
+			    -1);
+	g_free (title);
+
+	path = gtk_tree_model_get_path (model, &iter);
+	array_store_headers[info] = gtk_tree_row_reference_new (model, path);
+	gtk_tree_path_free (path);
 
-		/* right section? */
-		if (!is_package && info_tmp == info) {
-			*parent = iter;
-			ret = TRUE;
-			break;
+	*parent = iter;
+}
+
+/**
+ * gpk_update_viewer_progress_free:
+ **/
+static void
+gpk_update_viewer_progress_free (GpkUpdateViewerProgress *item)
+{
+	g_free (item->package_id);
+	g_free (item->summary);
+	g_free (item);
+}
+
+/**
+ * gpk_update_viewer_progress_apply:
+ *
+ * Applies the latest status of a package to its row, adding the row when
+ * the transaction pulled in a package that was not in the update list.
+ **/
+static GtkTreePath *
+gpk_update_viewer_progress_apply (GtkTreeModel *model, GpkUpdateViewerProgress *item)
+{
+	GtkTreeIter iter;
+	GtkTreePath *path;
+	PkInfoEnum status;
+	guint size;
+	gchar *text;
+
+	path = gpk_update_viewer_model_get_path (model, item->package_id);
+	if (path == NULL) {
+		if (!item->has_package) {
+			g_debug ("not found ID for %s", item->package_id);
+			return NULL;
 		}
+		g_debug ("Not found %s", item->package_id);
 
-		valid = gtk_tree_model_iter_next (model, &iter);
-	}
+		text = gpk_package_id_format_details (item->package_id, item->summary, TRUE);
+		g_debug ("adding: id=%s, text=%s", item->package_id, text);
 
-	/* create */
-	if (!ret) {
-		title = g_strdup_printf ("<b>%s</b>",
-					 gpk_update_view_get_info_headers (info));
+		/* add to model */
 		gtk_tree_store_append (array_store_updates, &iter, NULL);
 		gtk_tree_store_set (array_store_updates, &iter,
-				    GPK_UPDATES_COLUMN_TEXT, title,
-				    GPK_UPDATES_COLUMN_ID, NULL,
-				    GPK_UPDATES_COLUMN_INFO, info,
+				    GPK_UPDATES_COLUMN_TEXT, text,
+				    GPK_UPDATES_COLUMN_ID, item->package_id,
+				    GPK_UPDATES_COLUMN_INFO, item->info,
 				    GPK_UPDATES_COLUMN_SELECT, TRUE,
-				    GPK_UPDATES_COLUMN_VISIBLE, FALSE,
+				    GPK_UPDATES_COLUMN_VISIBLE, TRUE,
+				    GPK_UPDATES_COLUMN_SENSITIVE, FALSE,
 				    GPK_UPDATES_COLUMN_CLICKABLE, FALSE,
 				    GPK_UPDATES_COLUMN_RESTART, PK_RESTART_ENUM_NONE,
 				    GPK_UPDATES_COLUMN_STATUS, PK_INFO_ENUM_UNKNOWN,
 				    GPK_UPDATES_COLUMN_SIZE, 0,
 				    GPK_UPDATES_COLUMN_SIZE_DISPLAY, 0,
+				    GPK_UPDATES_COLUMN_DOWNLOAD_SIZE, 0,
+				    -1);
+		g_free (text);
+		gpk_update_viewer_model_add_row (model, &iter, item->package_id);
+		gpk_update_viewer_selection_account (model, &iter, TRUE);
+		path = gtk_tree_model_get_path (model, &iter);
+	}
+
+	gtk_tree_model_get_iter (model, &iter, path);
+
+	/* show the remaining download size */
+	if (item->percentage > 0) {
+		gtk_tree_model_get (model, &iter,
+				    GPK_UPDATES_COLUMN_SIZE, &size,
+				    -1);
+		gtk_tree_store_set (array_store_updates, &iter,
+				    GPK_UPDATES_COLUMN_SIZE_DISPLAY, size - ((size * item->percentage) / 100),
 				    -1);
-		*parent = iter;
-		g_free (title);
 	}
+
+	/* only change the status when we're doing the actual update */
+	if (item->has_package && item->role == PK_ROLE_ENUM_UPDATE_PACKAGES) {
+		/* if we are adding deps, then select the checkbox */
+		gpk_update_viewer_set_selected (model, &iter, TRUE);
+
+		status = item->status;
+		if (item->finished) {
+			/* clear the remaining size */
+			gtk_tree_store_set (array_store_updates, &iter,
+					    GPK_UPDATES_COLUMN_SIZE_DISPLAY, 0, -1);
+
+			/* promote the current status to past tense */
+			if (status == PK_INFO_ENUM_UNKNOWN) {
+				gtk_tree_model_get (model, &iter,
+						    GPK_UPDATES_COLUMN_STATUS, &status, -1);
+				if (status < PK_INFO_ENUM_LAST)
+					status += PK_INFO_ENUM_LAST;
+			}
+		}
+		if (status != PK_INFO_ENUM_UNKNOWN) {
+			gtk_tree_store_set (array_store_updates, &iter,
+					    GPK_UPDATES_COLUMN_STATUS, status, -1);
+		}
+	}
+
+	return path;
+}
+
+/**
+ * gpk_update_viewer_progress_flush:
+ *
+ * Applies all the queued package progress to the model in one go.
+ **/
+static void
+gpk_update_viewer_progress_flush (void)
+{
+	GpkUpdateViewerProgress *item;
+	GtkTreeView *treeview;
+	GtkTreeModel *model;
+	GtkTreeViewColumn *column;
+	GtkTreePath *path;
+	GtkTreePath *scroll_path = NULL;
+	guint i;
+
+	if (progress_flush_id != 0) {
+		g_source_remove (progress_flush_id);
+		progress_flush_id = 0;
+	}
+	if (progress_queue->len == 0)
+		return;
+
+	treeview = GTK_TREE_VIEW(gtk_builder_get_object (builder, "treeview_updates"));
+	model = gtk_tree_view_get_model (treeview);
+
+	for (i = 0; i < progress_queue->len; i++) {
+		item = g_ptr_array_index (progress_queue, i);
+		path = gpk_update_viewer_progress_apply (model, item);
+		if (path == NULL)
+			continue;
+
+		/* only the last active package is worth scrolling to */
+		if (item->has_package) {
+			gtk_tree_path_free (scroll_path);
+			scroll_path = path;
+		} else {
+			gtk_tree_path_free (path);
+		}
+	}
+
+	/* scroll to the active cell */
+	if (scroll_path != NULL) {
+		if (g_settings_get_boolean (settings, GPK_SETTINGS_SCROLL_ACTIVE)) {
+			column = gtk_tree_view_get_column (treeview, 3);
+			gtk_tree_view_scroll_to_cell (treeview, scroll_path, column, FALSE, 0.0f, 0.0f);
+		}
+		gtk_tree_path_free (scroll_path);
+	}
+
+	g_hash_table_remove_all (progress_pending);
+	g_ptr_array_set_size (progress_queue, 0);
+}
+
+/**
+ * gpk_update_viewer_progress_clear:
+ **/
+static void
+gpk_update_viewer_progress_clear (void)
+{
+	if (progress_flush_id != 0) {
+		g_source_remove (progress_flush_id);
+		progress_flush_id = 0;
+	}
+	g_hash_table_remove_all (progress_pending);
+	g_ptr_array_set_size (progress_queue, 0);
+}
+
+/**
+ * gpk_update_viewer_progress_flush_cb:
+ **/
+static gboolean
+gpk_update_viewer_progress_flush_cb (gpointer user_data)
+{
+	progress_flush_id = 0;
+	gpk_update_viewer_progress_flush ();
+	return G_SOURCE_REMOVE;
+}
+
+/**
+ * gpk_update_viewer_progress_get_item:
+ *
+ * Gets the queued progress of a package, so only the latest status of
+ * each package reaches the model in the next frame.
+ **/
+static GpkUpdateViewerProgress *
+gpk_update_viewer_progress_get_item (const gchar *package_id)
+{
+	GpkUpdateViewerProgress *item;
+
+	item = g_hash_table_lookup (progress_pending, package_id);
+	if (item != NULL)
+		return item;
+
+	item = g_new0 (GpkUpdateViewerProgress, 1);
+	item->package_id = g_strdup (package_id);
+	item->status = PK_INFO_ENUM_UNKNOWN;
+	item->percentage = -1;
+	g_ptr_array_add (progress_queue, item);
+	g_hash_table_insert (progress_pending, item->package_id, item);
+
+	if (progress_flush_id == 0) {
+		progress_flush_id = g_timeout_add (GPK_UPDATE_VIEWER_PROGRESS_INTERVAL,
+						   gpk_update_viewer_progress_flush_cb, NULL);
+		g_source_set_name_by_id (progress_flush_id, "[GpkUpdateViewer] progress");
+	}
+	return item;
+}
+
+/**
+ * gpk_update_viewer_progress_queue_package:
+ **/
+static void
+gpk_update_viewer_progress_queue_package (PkRoleEnum role,
+					  const gchar *package_id,
+					  const gchar *summary,
+					  PkInfoEnum info)
+{
+	GpkUpdateViewerProgress *item;
+
+	item = gpk_update_viewer_progress_get_item (package_id);
+	if (!item->has_package) {
+		item->has_package = TRUE;
+		item->info = info;
+		item->summary = g_strdup (summary);
+	}
+	item->role = role;
+
+	if (role != PK_ROLE_ENUM_UPDATE_PACKAGES)
+		return;
+
+	/* if the info is finished, change the status to past tense */
+	if (info == PK_INFO_ENUM_FINISHED) {
+		if (item->status != PK_INFO_ENUM_UNKNOWN && item->status < PK_INFO_ENUM_LAST)
+			item->status += PK_INFO_ENUM_LAST;
+		item->finished = TRUE;
+		item->percentage = -1;
+	} else {
+		item->status = info;
+		item->finished = FALSE;
+	}
+}
+
+/**
+ * gpk_update_viewer_progress_queue_item:
+ **/
+static void
+gpk_update_viewer_progress_queue_item (const gchar *package_id, gint percentage)
+{
+	GpkUpdateViewerProgress *item;
+
+	if (package_id == NULL)
+		return;
+
+	item = gpk_update_viewer_progress_get_item (package_id);
+	item->percentage = percentage;
 }
 
 /**
@@ -672,7 +1084,6 @@ gpk_update_viewer_progress_cb (PkProgress *progress,
 {
 	gboolean allow_cancel;
 	PkPackage *package = NULL;
-	gchar *text = NULL;
 	gint percentage;
 	GtkWidget *widget;
 	guint64 transaction_flags;
@@ -693,13 +1104,6 @@ gpk_update_viewer_progress_cb (PkProgress *progress,
 
 	if (type == PK_PROGRESS_TYPE_PACKAGE) {
 
-		GtkTreeView *treeview;
-		GtkTreeIter iter;
-		GtkTreeModel *model;
-		GtkTreeViewColumn *column;
-		GtkTreePath *path;
-		gboolean scroll;
-
 		/* ignore simulation phase */
 		if (pk_bitfield_contain (transaction_flags, PK_TRANSACTION_FLAG_ENUM_SIMULATE))
 			goto out;
@@ -714,91 +1118,22 @@ gpk_update_viewer_progress_cb (PkProgress *progress,
 			      "summary", &summary,
 			      NULL);
 
-		/* find model */
-		treeview = GTK_TREE_VIEW(gtk_builder_get_object (builder, "treeview_updates"));
-		model = gtk_tree_view_get_model (treeview);
-
-		/* update icon */
-		path = gpk_update_viewer_model_get_path (model, package_id);
-		if (path == NULL) {
-			g_debug ("Not found %s", package_id);
+		gpk_update_viewer_progress_queue_package (role, package_id, summary, info);
 
-			text = gpk_package_id_format_details (package_id, summary, TRUE);
-			g_debug ("adding: id=%s, text=%s", package_id, text);
+	} else if (type == PK_PROGRESS_TYPE_STATUS) {
 
-			/* add to model */
-			gtk_tree_store_append (array_store_updates, &iter, NULL);
-			gtk_tree_store_set (array_store_updates, &iter,
-					    GPK_UPDATES_COLUMN_TEXT, text,
-					    GPK_UPDATES_COLUMN_ID, package_id,
-					    GPK_UPDATES_COLUMN_INFO, info,
-					    GPK_UPDATES_COLUMN_SELECT, TRUE,
-					    GPK_UPDATES_COLUMN_VISIBLE, TRUE,
-					    GPK_UPDATES_COLUMN_SENSITIVE, FALSE,
-					    GPK_UPDATES_COLUMN_CLICKABLE, FALSE,
-					    GPK_UPDATES_COLUMN_RESTART, PK_RESTART_ENUM_NONE,
-					    GPK_UPDATES_COLUMN_STATUS, PK_INFO_ENUM_UNKNOWN,
-					    GPK_UPDATES_COLUMN_SIZE, 0,
-					    GPK_UPDATES_COLUMN_SIZE_DISPLAY, 0,
-					    -1);
-			g_free (text);
-			path = gpk_update_viewer_model_get_path (model, package_id);
-			if (path == NULL) {
-				g_warning ("found no package %s", package_id);
-				goto out;
-			}
-		}
+		GdkWindow *window;
+		const gchar *title;
+		GdkDisplay *display;
+		GdkCursor *cursor;
 
-		gtk_tree_model_get_iter (model, &iter, path);
+		g_debug ("status %s", pk_status_enum_to_string (status));
 
-		/* if we are adding deps, then select the checkbox */
-		if (role == PK_ROLE_ENUM_UPDATE_PACKAGES) {
-			gtk_tree_store_set (array_store_updates, &iter,
-					    GPK_UPDATES_COLUMN_SELECT, TRUE,
-					    -1);
-		}
-
-		/* scroll to the active cell */
-		scroll = g_settings_get_boolean (settings, GPK_SETTINGS_SCROLL_ACTIVE);
-		if (scroll) {
-			column = gtk_tree_view_get_column (treeview, 3);
-			gtk_tree_view_scroll_to_cell (treeview, path, column, FALSE, 0.0f, 0.0f);
-		}
-
-		/* only change the status when we're doing the actual update */
-		if (role == PK_ROLE_ENUM_UPDATE_PACKAGES) {
-			/* if the info is finished, change the status to past tense */
-			if (info == PK_INFO_ENUM_FINISHED) {
-				/* clear the remaining size */
-				gtk_tree_store_set (array_store_updates, &iter,
-						    GPK_UPDATES_COLUMN_SIZE_DISPLAY, 0, -1);
-
-				gtk_tree_model_get (model, &iter,
-						    GPK_UPDATES_COLUMN_STATUS, &info, -1);
-				/* promote to past tense if present tense */
-				if (info < PK_INFO_ENUM_LAST)
-					info += PK_INFO_ENUM_LAST;
-			}
-			gtk_tree_store_set (array_store_updates, &iter,
-					    GPK_UPDATES_COLUMN_STATUS, info, -1);
-		}
-
-		gtk_tree_path_free (path);
-
-	} else if (type == PK_PROGRESS_TYPE_STATUS) {
-
-		GdkWindow *window;
-		const gchar *title;
-		GdkDisplay *display;
-		GdkCursor *cursor;
-
-		g_debug ("status %s", pk_status_enum_to_string (status));
-
-		/* use correct status pane */
-		widget = GTK_WIDGET(gtk_builder_get_object (builder, "hbox_status"));
-		gtk_widget_show (widget);
-		widget = GTK_WIDGET(gtk_builder_get_object (builder, "hbox_info"));
-		gtk_widget_hide (widget);
+		/* use correct status pane */
+		widget = GTK_WIDGET(gtk_builder_get_object (builder, "hbox_status"));
+		gtk_widget_show (widget);
+		widget = GTK_WIDGET(gtk_builder_get_object (builder, "hbox_info"));
+		gtk_widget_hide (widget);
 
 		/* set cursor back to normal */
 		window = gtk_widget_get_window (widget);
@@ -847,12 +1182,6 @@ gpk_update_viewer_progress_cb (PkProgress *progress,
 
 	} else if (type == PK_PROGRESS_TYPE_ITEM_PROGRESS) {
 
-		GtkTreeView *treeview;
-		GtkTreeModel *model;
-		GtkTreeIter iter;
-		GtkTreePath *path;
-		guint size;
-		guint size_display;
 		PkItemProgress *item_progress;
 
 		/* ignore simulation phase */
@@ -863,28 +1192,20 @@ gpk_update_viewer_progress_cb (PkProgress *progress,
 			      "item-progress", &item_progress,
 			      NULL);
 
-		treeview = GTK_TREE_VIEW(gtk_builder_get_object (builder, "treeview_updates"));
-		model = gtk_tree_view_get_model (treeview);
-		path = gpk_update_viewer_model_get_path (model,
-							 pk_item_progress_get_package_id (item_progress));
-		if (path == NULL) {
-			g_debug ("not found ID for %s",
-				 pk_item_progress_get_package_id (item_progress));
-			goto out;
-		}
+		gpk_update_viewer_progress_queue_item (pk_item_progress_get_package_id (item_progress),
+						       pk_item_progress_get_percentage (item_progress));
+		g_object_unref (item_progress);
 
-		gtk_tree_model_get_iter (model, &iter, path);
-		gtk_tree_model_get (model, &iter,
-				    GPK_UPDATES_COLUMN_SIZE, &size,
-				    -1);
-		percentage = pk_item_progress_get_percentage (item_progress);
-		if (percentage > 0) {
-			size_display = size - ((size * percentage) / 100);
-			gtk_tree_store_set (array_store_updates, &iter,
-					    GPK_UPDATES_COLUMN_SIZE_DISPLAY, size_display,
-					    -1);
-		}
-		gtk_tree_path_free (path);
+	} else if (type == PK_PROGRESS_TYPE_SPEED) {
+
+		guint speed;
+
+		/* learn the rate of the real downloads, in bits per second */
+		g_object_get (progress,
+			      "speed", &speed,
+			      NULL);
+		if (status == PK_STATUS_ENUM_DOWNLOAD)
+			download_rate = gpk_download_rate_update (download_rate, speed / 8);
 	}
 out:
 	g_free (summary);
@@ -1063,6 +1384,35 @@ gpk_update_viewer_button_upgrade_cb (GtkWidget *widget, gpointer user_data)
 	}
 }
 
+/**
+ * gpk_update_viewer_get_download_estimate:
+ *
+ * Returns: what the selection needs to download, and how long it would take
+ * at the rate of the past downloads, e.g. "12.3 MB to download, about 2 minutes"
+ **/
+static gchar *
+gpk_update_viewer_get_download_estimate (void)
+{
+	gchar *text_size;
+	gchar *text_time;
+	gchar *text;
+
+	text_size = g_format_size (download_selected);
+	if (download_rate == 0) {
+		/* TRANSLATORS: the size of the packages to download */
+		text = g_strdup_printf (_("%s to download"), text_size);
+		g_free (text_size);
+		return text;
+	}
+
+	text_time = gpk_time_to_imprecise_string (MAX (download_selected / download_rate, 1));
+	/* TRANSLATORS: the size of the packages to download, and the time it would take */
+	text = g_strdup_printf (_("%s to download, about %s"), text_size, text_time);
+	g_free (text_time);
+	g_free (text_size);
+	return text;
+}
+
 /**
  * gpk_update_viewer_check_mobile_broadband:
  **/
@@ -1071,6 +1421,9 @@ gpk_update_viewer_check_mobile_broadband (void)
 {
 	PkNetworkEnum state;
 	const gchar *message;
+	gchar *estimate;
+	gchar *text;
+	guint size;
 
 	/* get network state */
 	g_object_get (control,
@@ -1084,101 +1437,53 @@ gpk_update_viewer_check_mobile_broadband (void)
 	if (state != PK_NETWORK_ENUM_MOBILE)
 		return;
 
-	/* not when small */
-	if (size_selected < GPK_UPDATE_VIEWER_MOBILE_SMALL_SIZE)
+	/* not when small, the packages already downloaded are free once
+	 * the details of every package are known */
+	size = details_complete ? download_selected : size_selected;
+	if (size < GPK_UPDATE_VIEWER_MOBILE_SMALL_SIZE)
 		return;
 
 	/* TRANSLATORS, are we going to cost the user lots of money? */
 	message = ngettext ("Connectivity is being provided by wireless broadband, and it may be expensive to update this package.",
 			    "Connectivity is being provided by wireless broadband, and it may be expensive to update these packages.",
 			    number_selected);
-	gtk_label_set_label (GTK_LABEL(info_mobile_label), message);
+	if (details_complete) {
+		estimate = gpk_update_viewer_get_download_estimate ();
+		text = g_strdup_printf ("%s\n%s", message, estimate);
+		gtk_label_set_label (GTK_LABEL(info_mobile_label), text);
+		g_free (estimate);
+		g_free (text);
+	} else {
+		gtk_label_set_label (GTK_LABEL(info_mobile_label), message);
+	}
 
 	gtk_info_bar_set_message_type (GTK_INFO_BAR(info_mobile), GTK_MESSAGE_WARNING);
 	gtk_widget_show (info_mobile);
 }
 
-/**
- * gpk_update_viewer_update_global_state_recursive:
- **/
-static void
-gpk_update_viewer_update_global_state_recursive (GtkTreeModel *model, GtkTreeIter *iter)
-{
-	gboolean selected, prepared;
-	PkRestartEnum restart;
-	guint size;
-	gchar *package_id = NULL;
-	gboolean child_valid;
-	GtkTreeIter child_iter;
-
-	gtk_tree_model_get (model, iter,
-	                    GPK_UPDATES_COLUMN_SELECT, &selected,
-	                    GPK_UPDATES_COLUMN_RESTART, &restart,
-	                    GPK_UPDATES_COLUMN_PREPARED, &prepared,
-	                    GPK_UPDATES_COLUMN_SIZE, &size,
-	                    GPK_UPDATES_COLUMN_ID, &package_id,
-	                    -1);
-
-	if (selected && package_id != NULL) {
-		size_selected += size;
-		number_selected++;
-		if (restart > restart_worst)
-			restart_worst = restart;
-		if (all_prepared)
-			all_prepared = prepared;
-	}
-
-	/* child entries */
-	child_valid = gtk_tree_model_iter_children (model, &child_iter, iter);
-	while (child_valid) {
-		gpk_update_viewer_update_global_state_recursive (model, &child_iter);
-		child_valid = gtk_tree_model_iter_next (model, &child_iter);
-	}
-	g_free (package_id);
-}
-
 /**
  * gpk_update_viewer_update_global_state:
  **/
 static void
 gpk_update_viewer_update_global_state (void)
 {
-	gboolean valid;
-	GtkTreeIter iter;
-	GtkTreeView *treeview;
-	GtkTreeModel *model;
+	guint i;
 
-	/* reset to zero */
-	size_selected = 0;
-	number_selected = 0;
+	/* the totals are kept up to date as the rows change */
 	restart_worst = PK_RESTART_ENUM_NONE;
-	all_prepared = TRUE;
-
-	treeview = GTK_TREE_VIEW(gtk_builder_get_object (builder, "treeview_updates"));
-	model = gtk_tree_view_get_model (treeview);
-
-	/* if there are no entries selected, deselect the button */
-	valid = gtk_tree_model_get_iter_first (model, &iter);
-	while (valid) {
-		gpk_update_viewer_update_global_state_recursive (model, &iter);
-		valid = gtk_tree_model_iter_next (model, &iter);
+	for (i = 0; i < PK_RESTART_ENUM_LAST; i++) {
+		if (restart_selected[i] > 0)
+			restart_worst = i;
 	}
+	all_prepared = (unprepared_selected == 0);
 }
 
 
-static gboolean
-gpk_updates_viewer_validate_cache_timeout (gpointer data)
-{
-	g_debug ("Must update last checked label");
-
-	gpk_updates_viewer_validate_cache ();
-
-	return G_SOURCE_CONTINUE;
-}
-
 static void
 gpk_updates_viewer_stop_validate_cache (void)
 {
+	last_refresh_shown = FALSE;
+
 	if (last_refresh_id == 0)
 		return;
 
@@ -1186,13 +1491,19 @@ gpk_updates_viewer_stop_validate_cache (void)
 	last_refresh_id = 0;
 }
 
-static void
-gpk_updates_viewer_start_validate_cache (void)
+/*
+ * The seconds until the "Last checked" label changes its text.
+ */
+static guint
+gpk_updates_viewer_last_checked_next (guint seconds_ago)
 {
-	last_refresh_id
-		= g_timeout_add_seconds (SECONDS_IN_AN_MINUTE,
-		                         gpk_updates_viewer_validate_cache_timeout,
-		                         NULL);
+	if (seconds_ago < 5 * SECONDS_IN_AN_MINUTE)
+		return 5 * SECONDS_IN_AN_MINUTE - seconds_ago;
+	if (seconds_ago < SECONDS_IN_AN_HOUR)
+		return SECONDS_IN_AN_MINUTE - seconds_ago % SECONDS_IN_AN_MINUTE;
+	if (seconds_ago < SECONDS_IN_A_DAY)
+		return SECONDS_IN_AN_HOUR - seconds_ago % SECONDS_IN_AN_HOUR;
+	return SECONDS_IN_A_DAY - seconds_ago % SECONDS_IN_A_DAY;
 }
 
 /**
@@ -1222,7 +1533,7 @@ gpk_update_viewer_empty_stack_message (const gchar *title,
 
 	gpk_updates_viewer_stop_validate_cache ();
 	if (updated) {
-		gpk_updates_viewer_start_validate_cache ();
+		last_refresh_shown = TRUE;
 		gpk_updates_viewer_validate_cache ();
 	}
 
@@ -1230,13 +1541,29 @@ gpk_update_viewer_empty_stack_message (const gchar *title,
 	gtk_stack_set_visible_child_name (GTK_STACK (widget), "empty");
 }
 
+static gboolean
+gpk_updates_viewer_last_checked_timeout (gpointer data)
+{
+	g_debug ("Must update last checked label");
+
+	last_refresh_id = 0;
+	gpk_updates_viewer_refresh_cache_done ();
+
+	return G_SOURCE_REMOVE;
+}
+
 static void
 gpk_updates_viewer_refresh_cache_done (void)
 {
 	GtkWidget *widget;
 	gchar *label = NULL, *time = NULL;
+	guint seconds_ago;
 
-	time = gpk_time_ago_to_localised_string (last_resfreh_ago);
+	if (!last_refresh_shown)
+		return;
+
+	seconds_ago = (guint) ((g_get_monotonic_time () - last_refresh_time) / G_USEC_PER_SEC);
+	time = gpk_time_ago_to_localised_string (seconds_ago);
 
 	label = g_strdup_printf(_("Last checked: %s"), time);
 	widget = GTK_WIDGET(gtk_builder_get_object (builder, "label_empty_checked"));
@@ -1245,6 +1572,14 @@ gpk_updates_viewer_refresh_cache_done (void)
 	widget = GTK_WIDGET(gtk_builder_get_object (builder, "button_check"));
 	gtk_widget_show (widget);
 
+	/* wake up just when the text changes, without asking PackageKit again */
+	if (last_refresh_id != 0)
+		g_source_remove (last_refresh_id);
+	last_refresh_id
+		= g_timeout_add_seconds (gpk_updates_viewer_last_checked_next (seconds_ago),
+		                         gpk_updates_viewer_last_checked_timeout,
+		                         NULL);
+
 	g_free (label);
 	g_free (time);
 }
@@ -1283,9 +1618,9 @@ gpk_update_viewer_reconsider_info (void)
 		goto out;
 	}
 
-	/* action button */
+	/* action button, never for the list saved the last time */
 	widget = GTK_WIDGET(gtk_builder_get_object (builder, "button_install"));
-	gtk_widget_set_sensitive (widget, (number_selected > 0));
+	gtk_widget_set_sensitive (widget, (number_selected > 0 && !update_list_stale));
 
 	/* sensitive */
 	widget = GTK_WIDGET(gtk_builder_get_object (builder, "scrolledwindow_updates"));
@@ -1300,7 +1635,9 @@ gpk_update_viewer_reconsider_info (void)
 	gtk_button_set_label (GTK_BUTTON (widget), title);
 
 	/* no updates */
-	if (update_array != NULL) {
+	if (update_list_stale) {
+		len = snapshot_items->len;
+	} else if (update_array != NULL) {
 		len = update_array->len;
 		if (len == 0) {
 			g_debug ("no updates");
@@ -1348,7 +1685,10 @@ gpk_update_viewer_reconsider_info (void)
 
 	/* total */
 	widget = GTK_WIDGET(gtk_builder_get_object (builder, "headerbar"));
-	if (number_selected == 0) {
+	if (update_list_stale) {
+		/* TRANSLATORS: the list shown is the one from the last time */
+		gtk_header_bar_set_subtitle (GTK_HEADER_BAR(widget), _("Checking for updates…"));
+	} else if (number_selected == 0) {
 		gtk_header_bar_set_subtitle (GTK_HEADER_BAR(widget), NULL);
 	} else {
 		if (size_selected == 0) {
@@ -1360,7 +1700,12 @@ gpk_update_viewer_reconsider_info (void)
 			gtk_header_bar_set_subtitle (GTK_HEADER_BAR(widget), text);
 			g_free (text);
 		} else {
-			text_size = g_format_size (size_selected);
+			/* only tell what is left to download when known for
+			 * every package, the saved list has no download sizes */
+			if (details_complete && download_selected > 0)
+				text_size = gpk_update_viewer_get_download_estimate ();
+			else
+				text_size = g_format_size (size_selected);
 			/* TRANSLATORS: how many updates are selected in the UI, and the size of packages to download */
 			text = g_strdup_printf (ngettext ("%u update selected (%s)",
 			                                  "%u updates selected (%s)",
@@ -1405,13 +1750,12 @@ gpk_update_viewer_treeview_update_toggled (GtkCellRendererToggle *cell, gchar *p
 	g_free (package_id);
 
 	/* set new value */
-	gtk_tree_store_set (GTK_TREE_STORE(model), &iter, GPK_UPDATES_COLUMN_SELECT, update, -1);
+	gpk_update_viewer_set_selected (model, &iter, update);
 
 	/* do the same for any children */
 	child_valid = gtk_tree_model_iter_children (model, &child_iter, &iter);
 	while (child_valid) {
-		gtk_tree_store_set (GTK_TREE_STORE(model), &child_iter,
-				    GPK_UPDATES_COLUMN_SELECT, update, -1);
+		gpk_update_viewer_set_selected (model, &child_iter, update);
 		child_valid = gtk_tree_model_iter_next (model, &child_iter);
 	}
 
@@ -1905,11 +2249,114 @@ gpk_packages_treeview_dont_select_headings (GtkTreeSelection *selection,
 	return ret;
 }
 
+/**
+ * gpk_update_viewer_details_chunk_done:
+ *
+ * Each chunk asks for the details and the update details of the same
+ * packages, the next chunk is requested once both have been applied.
+ **/
+static void
+gpk_update_viewer_details_chunk_done (GpkUpdateViewerDetailsChunk *chunk)
+{
+	if (--chunk->pending > 0)
+		return;
+	if (!g_cancellable_is_cancelled (chunk->cancellable))
+		gpk_update_viewer_details_fetch_next ();
+	g_object_unref (chunk->cancellable);
+	g_free (chunk);
+}
+
+/**
+ * gpk_update_viewer_details_failed:
+ *
+ * Shows the first error of the fetch, the remaining chunks are still
+ * requested so one bad package does not leave the rest without details.
+ **/
+static void
+gpk_update_viewer_details_failed (GpkUpdateViewerDetailsChunk *chunk,
+				  const gchar *title,
+				  GError *error,
+				  PkError *error_code)
+{
+	GtkWindow *window;
+
+	if (g_cancellable_is_cancelled (chunk->cancellable))
+		return;
+	if (details_error_shown)
+		return;
+	details_error_shown = TRUE;
+
+	if (error != NULL) {
+		gpk_update_viewer_error_dialog (title, NULL, error->message);
+		return;
+	}
+
+	window = GTK_WINDOW(gtk_builder_get_object (builder, "dialog_updates"));
+	gpk_error_dialog_modal (window, gpk_error_enum_to_localised_text (pk_error_get_code (error_code)),
+				gpk_error_enum_to_localised_message (pk_error_get_code (error_code)), pk_error_get_details (error_code));
+}
+
+/**
+ * gpk_update_viewer_details_finished:
+ **/
+static void
+gpk_update_viewer_details_finished (void)
+{
+	GError *error = NULL;
+	GStrv prepared_ids = NULL;
+	GtkTreeIter iter;
+	GtkTreeModel *model;
+	GtkTreePath *path;
+	GtkTreeSelection *selection;
+	GtkWidget *widget;
+	guint i;
+
+	details_complete = TRUE;
+	gpk_update_viewer_snapshot_save ();
+
+	widget = GTK_WIDGET(gtk_builder_get_object (builder, "treeview_updates"));
+	model = gtk_tree_view_get_model (GTK_TREE_VIEW(widget));
+
+	prepared_ids = pk_offline_get_prepared_ids (&error);
+	if (error != NULL) {
+		g_warning ("failed to get prepared updates: %s", error->message);
+		g_error_free (error);
+		return;
+	}
+
+	for (i = 0; prepared_ids[i] != NULL; i++) {
+		g_debug ("prepared update: %s", prepared_ids[i]);
+		path = gpk_update_viewer_model_get_path (model, prepared_ids[i]);
+		if (path == NULL) {
+			g_warning ("not found ID for prepared update");
+			continue;
+		}
+
+		gtk_tree_model_get_iter (model, &iter, path);
+		gpk_update_viewer_selection_account (model, &iter, FALSE);
+		gtk_tree_store_set (array_store_updates, &iter,
+		                    GPK_UPDATES_COLUMN_PREPARED, TRUE, -1);
+		gpk_update_viewer_selection_account (model, &iter, TRUE);
+		gtk_tree_path_free (path);
+	}
+	g_strfreev (prepared_ids);
+
+	/* select the first entry in the updates array now we've got data */
+	selection = gtk_tree_view_get_selection (GTK_TREE_VIEW(widget));
+	gtk_tree_selection_unselect_all (selection);
+	path = gtk_tree_path_new_first ();
+	gtk_tree_selection_select_path (selection, path);
+	gtk_tree_path_free (path);
+
+	/* set info */
+	gpk_update_viewer_reconsider_info ();
+}
+
 /**
  * gpk_update_viewer_get_details_cb:
  **/
 static void
-gpk_update_viewer_get_details_cb (PkClient *client, GAsyncResult *res, gpointer user_data)
+gpk_update_viewer_get_details_cb (PkClient *client, GAsyncResult *res, GpkUpdateViewerDetailsChunk *chunk)
 {
 	PkResults *results = NULL;
 	GError *error = NULL;
@@ -1919,41 +2366,42 @@ gpk_update_viewer_get_details_cb (PkClient *client, GAsyncResult *res, gpointer
 	guint64 download_size;
 	guint64 size;
 	gchar *package_id = NULL;
-	GtkWidget *widget;
 	GtkTreePath *path;
 	GtkTreeModel *model;
-	GtkTreeSelection *selection;
 	GtkTreeView *treeview;
 	GtkTreeIter iter;
 	PkError *error_code = NULL;
-	GtkWindow *window;
-	GStrv prepared_ids = NULL;
 
 	/* get the results */
 	results = pk_client_generic_finish (client, res, &error);
 	if (results == NULL) {
 		/* TRANSLATORS: the PackageKit request did not complete, and it did not send an error */
-		gpk_update_viewer_error_dialog (_("Could not get update details"), NULL, error->message);
+		gpk_update_viewer_details_failed (chunk, _("Could not get update details"), error, NULL);
 		g_error_free (error);
 		goto out;
 	}
 
+	/* the list was reloaded */
+	if (g_cancellable_is_cancelled (chunk->cancellable))
+		goto out;
+
 	/* check error code */
 	error_code = pk_results_get_error_code (results);
 	if (error_code != NULL) {
 		g_warning ("failed to get details: %s, %s", pk_error_enum_to_string (pk_error_get_code (error_code)), pk_error_get_details (error_code));
-
-		window = GTK_WINDOW(gtk_builder_get_object (builder, "dialog_updates"));
-		gpk_error_dialog_modal (window, gpk_error_enum_to_localised_text (pk_error_get_code (error_code)),
-					gpk_error_enum_to_localised_message (pk_error_get_code (error_code)), pk_error_get_details (error_code));
+		gpk_update_viewer_details_failed (chunk, NULL, NULL, error_code);
 		goto out;
 	}
 
 	/* get data */
 	array = pk_results_get_details_array (results);
 	if (array->len == 0) {
-		/* TRANSLATORS: PackageKit did not send any results for the query... */
-		gpk_update_viewer_error_dialog (_("Could not get update details"), _("No results were returned."), NULL);
+		/* only once for all the chunks */
+		if (!details_error_shown) {
+			details_error_shown = TRUE;
+			/* TRANSLATORS: PackageKit did not send any results for the query... */
+			gpk_update_viewer_error_dialog (_("Could not get update details"), _("No results were returned."), NULL);
+		}
 		goto out;
 	}
 
@@ -1976,11 +2424,14 @@ gpk_update_viewer_get_details_cb (PkClient *client, GAsyncResult *res, gpointer
 		} else {
 			gtk_tree_model_get_iter (model, &iter, path);
 			gtk_tree_path_free (path);
+			gpk_update_viewer_selection_account (model, &iter, FALSE);
 			gtk_tree_store_set (array_store_updates, &iter,
 					    GPK_UPDATES_COLUMN_DETAILS_OBJ, (gpointer) g_object_ref (item),
 					    GPK_UPDATES_COLUMN_SIZE, (gint)size,
 					    GPK_UPDATES_COLUMN_SIZE_DISPLAY, (gint)size,
+					    GPK_UPDATES_COLUMN_DOWNLOAD_SIZE, (guint)download_size,
 					    -1);
+			gpk_update_viewer_selection_account (model, &iter, TRUE);
 			/* in cache */
 			if (size > 0 && download_size == 0)
 				gtk_tree_store_set (array_store_updates, &iter,
@@ -1989,55 +2440,24 @@ gpk_update_viewer_get_details_cb (PkClient *client, GAsyncResult *res, gpointer
 		g_free (package_id);
 	}
 
-	prepared_ids = pk_offline_get_prepared_ids (&error);
-	if (error != NULL) {
-		g_warning ("failed to get prepared updates: %s", error->message);
-		g_error_free (error);
-		goto out;
-	}
-
-	for (i = 0; prepared_ids[i] != NULL; i++) {
-		g_debug ("prepared update: %s", prepared_ids[i]);
-		path = gpk_update_viewer_model_get_path (model, prepared_ids[i]);
-		if (path == NULL) {
-			g_warning ("not found ID for prepared update");
-			continue;
-		}
-
-		gtk_tree_model_get_iter (model, &iter, path);
-		gtk_tree_store_set (array_store_updates, &iter,
-		                    GPK_UPDATES_COLUMN_PREPARED, TRUE, -1);
-		gtk_tree_path_free (path);
-	}
-
-	/* select the first entry in the updates array now we've got data */
-	widget = GTK_WIDGET(gtk_builder_get_object (builder, "treeview_updates"));
-	selection = gtk_tree_view_get_selection (GTK_TREE_VIEW(widget));
-	gtk_tree_selection_unselect_all (selection);
-	path = gtk_tree_path_new_first ();
-	gtk_tree_selection_select_path (selection, path);
-	gtk_tree_path_free (path);
-
 	/* set info */
 	gpk_update_viewer_reconsider_info ();
 
 out:
+	gpk_update_viewer_details_chunk_done (chunk);
 	if (error_code != NULL)
 		g_object_unref (error_code);
 	if (array != NULL)
 		g_ptr_array_unref (array);
 	if (results != NULL)
 		g_object_unref (results);
-	if (prepared_ids)
-		g_strfreev (prepared_ids);
-
 }
 
 /**
  * gpk_update_viewer_get_update_detail_cb:
  **/
 static void
-gpk_update_viewer_get_update_detail_cb (PkClient *client, GAsyncResult *res, gpointer user_data)
+gpk_update_viewer_get_update_detail_cb (PkClient *client, GAsyncResult *res, GpkUpdateViewerDetailsChunk *chunk)
 {
 	PkResults *results = NULL;
 	GError *error = NULL;
@@ -2049,7 +2469,6 @@ gpk_update_viewer_get_update_detail_cb (PkClient *client, GAsyncResult *res, gpo
 	GtkTreeIter iter;
 	GtkTreePath *path;
 	PkError *error_code = NULL;
-	GtkWindow *window;
 	gchar *package_id = NULL;
 	PkRestartEnum restart;
 
@@ -2057,19 +2476,20 @@ gpk_update_viewer_get_update_detail_cb (PkClient *client, GAsyncResult *res, gpo
 	results = pk_client_generic_finish (client, res, &error);
 	if (results == NULL) {
 		/* TRANSLATORS: the PackageKit request did not complete, and it did not send an error */
-		gpk_update_viewer_error_dialog (_("Could not get update details"), NULL, error->message);
+		gpk_update_viewer_details_failed (chunk, _("Could not get update details"), error, NULL);
 		g_error_free (error);
 		goto out;
 	}
 
+	/* the list was reloaded */
+	if (g_cancellable_is_cancelled (chunk->cancellable))
+		goto out;
+
 	/* check error code */
 	error_code = pk_results_get_error_code (results);
 	if (error_code != NULL) {
 		g_warning ("failed to get update details: %s, %s", pk_error_enum_to_string (pk_error_get_code (error_code)), pk_error_get_details (error_code));
-
-		window = GTK_WINDOW(gtk_builder_get_object (builder, "dialog_updates"));
-		gpk_error_dialog_modal (window, gpk_error_enum_to_localised_text (pk_error_get_code (error_code)),
-					gpk_error_enum_to_localised_message (pk_error_get_code (error_code)), pk_error_get_details (error_code));
+		gpk_update_viewer_details_failed (chunk, NULL, NULL, error_code);
 		goto out;
 	}
 
@@ -2098,13 +2518,16 @@ gpk_update_viewer_get_update_detail_cb (PkClient *client, GAsyncResult *res, gpo
 		} else {
 			gtk_tree_model_get_iter (model, &iter, path);
 			gtk_tree_path_free (path);
+			gpk_update_viewer_selection_account (model, &iter, FALSE);
 			gtk_tree_store_set (array_store_updates, &iter,
 					    GPK_UPDATES_COLUMN_UPDATE_DETAIL_OBJ, (gpointer) g_object_ref (item),
 					    GPK_UPDATES_COLUMN_RESTART, restart, -1);
+			gpk_update_viewer_selection_account (model, &iter, TRUE);
 		}
 		g_free (package_id);
 	}
 out:
+	gpk_update_viewer_details_chunk_done (chunk);
 	if (error_code != NULL)
 		g_object_unref (error_code);
 	if (array != NULL)
@@ -2113,13 +2536,193 @@ out:
 		g_object_unref (results);
 }
 
+/**
+ * gpk_update_viewer_model_iter_next_row:
+ *
+ * Moves to the next row as shown in the expanded tree.
+ **/
+static gboolean
+gpk_update_viewer_model_iter_next_row (GtkTreeModel *model, GtkTreeIter *iter)
+{
+	GtkTreeIter tmp;
+
+	if (gtk_tree_model_iter_children (model, &tmp, iter)) {
+		*iter = tmp;
+		return TRUE;
+	}
+	while (TRUE) {
+		tmp = *iter;
+		if (gtk_tree_model_iter_next (model, &tmp)) {
+			*iter = tmp;
+			return TRUE;
+		}
+		if (!gtk_tree_model_iter_parent (model, &tmp, iter))
+			return FALSE;
+		*iter = tmp;
+	}
+}
+
+/**
+ * gpk_update_viewer_details_take:
+ *
+ * Removes a package from the pending set, returning the queued string.
+ **/
+static gboolean
+gpk_update_viewer_details_take (GPtrArray *chunk, const gchar *package_id)
+{
+	gpointer key;
+
+	if (!g_hash_table_lookup_extended (details_pending, package_id, &key, NULL))
+		return FALSE;
+	g_hash_table_remove (details_pending, key);
+	g_ptr_array_add (chunk, key);
+	return TRUE;
+}
+
+/**
+ * gpk_update_viewer_details_take_visible:
+ *
+ * The rows on screen are asked for first, so scrolling a long list moves
+ * the fetch along with it.
+ **/
+static void
+gpk_update_viewer_details_take_visible (GPtrArray *chunk)
+{
+	GtkTreeIter iter;
+	GtkTreeModel *model;
+	GtkTreePath *end = NULL;
+	GtkTreePath *path;
+	GtkTreePath *start = NULL;
+	GtkTreeView *treeview;
+	gboolean valid;
+	gchar *package_id;
+
+	treeview = GTK_TREE_VIEW(gtk_builder_get_object (builder, "treeview_updates"));
+	model = gtk_tree_view_get_model (treeview);
+	if (model == NULL)
+		return;
+	if (!gtk_tree_view_get_visible_range (treeview, &start, &end))
+		return;
+
+	valid = gtk_tree_model_get_iter (model, &iter, start);
+	while (valid && chunk->len < GPK_UPDATE_VIEWER_DETAILS_CHUNK) {
+		gtk_tree_model_get (model, &iter,
+				    GPK_UPDATES_COLUMN_ID, &package_id,
+				    -1);
+		if (package_id != NULL) {
+			gpk_update_viewer_details_take (chunk, package_id);
+			g_free (package_id);
+		}
+
+		path = gtk_tree_model_get_path (model, &iter);
+		valid = gtk_tree_path_compare (path, end) < 0;
+		gtk_tree_path_free (path);
+		if (valid)
+			valid = gpk_update_viewer_model_iter_next_row (model, &iter);
+	}
+
+	gtk_tree_path_free (start);
+	gtk_tree_path_free (end);
+}
+
+/**
+ * gpk_update_viewer_details_fetch_next:
+ **/
+static void
+gpk_update_viewer_details_fetch_next (void)
+{
+	GPtrArray *package_ids;
+	GpkUpdateViewerDetailsChunk *chunk;
+
+	package_ids = g_ptr_array_new ();
+	gpk_update_viewer_details_take_visible (package_ids);
+	while (package_ids->len < GPK_UPDATE_VIEWER_DETAILS_CHUNK &&
+	       details_queue_pos < details_queue->len) {
+		gpk_update_viewer_details_take (package_ids,
+						g_ptr_array_index (details_queue, details_queue_pos++));
+	}
+
+	/* all done */
+	if (package_ids->len == 0) {
+		g_ptr_array_unref (package_ids);
+		gpk_update_viewer_details_finished ();
+		return;
+	}
+	g_ptr_array_add (package_ids, NULL);
+
+	chunk = g_new0 (GpkUpdateViewerDetailsChunk, 1);
+	chunk->cancellable = g_object_ref (details_cancellable);
+	chunk->pending = 2;
+
+	/* get the details of the packages */
+	pk_client_get_update_detail_async (PK_CLIENT(task), (gchar **) package_ids->pdata, chunk->cancellable,
+					   (PkProgressCallback) gpk_update_viewer_progress_cb, NULL,
+					   (GAsyncReadyCallback) gpk_update_viewer_get_update_detail_cb, chunk);
+	pk_client_get_details_async (PK_CLIENT(task), (gchar **) package_ids->pdata, chunk->cancellable,
+				     (PkProgressCallback) gpk_update_viewer_progress_cb, NULL,
+				     (GAsyncReadyCallback) gpk_update_viewer_get_details_cb, chunk);
+
+	g_ptr_array_unref (package_ids);
+}
+
+/**
+ * gpk_update_viewer_details_stop:
+ **/
+static void
+gpk_update_viewer_details_stop (void)
+{
+	if (details_cancellable != NULL) {
+		g_cancellable_cancel (details_cancellable);
+		g_clear_object (&details_cancellable);
+	}
+	g_hash_table_remove_all (details_pending);
+	g_ptr_array_set_size (details_queue, 0);
+	details_queue_pos = 0;
+	details_complete = FALSE;
+}
+
+/**
+ * gpk_update_viewer_details_start:
+ *
+ * Asks for the details of the listed updates in chunks, in the order they
+ * are shown, so the sizes of the first screen appear without waiting for
+ * the whole list.
+ **/
+static void
+gpk_update_viewer_details_start (void)
+{
+	GtkTreeIter iter;
+	GtkTreeModel *model;
+	gboolean valid;
+	gchar *package_id;
+
+	gpk_update_viewer_details_stop ();
+	details_cancellable = g_cancellable_new ();
+	details_error_shown = FALSE;
+
+	model = GTK_TREE_MODEL (array_store_updates);
+	valid = gtk_tree_model_get_iter_first (model, &iter);
+	while (valid) {
+		gtk_tree_model_get (model, &iter,
+				    GPK_UPDATES_COLUMN_ID, &package_id,
+				    -1);
+		if (package_id != NULL) {
+			g_ptr_array_add (details_queue, package_id);
+			g_hash_table_add (details_pending, package_id);
+		}
+		valid = gpk_update_viewer_model_iter_next_row (model, &iter);
+	}
+
+	gpk_update_viewer_details_fetch_next ();
+}
+
 /**
  * gpk_update_viewer_repo_array_changed_cb:
  **/
 static void
 gpk_update_viewer_repo_array_changed_cb (PkClient *client, gpointer user_data)
 {
-	gpk_update_viewer_get_updates ();
+	gpk_update_viewer_get_shared_updates ();
 }
 
 /**
@@ -2143,14 +2746,12 @@ gpk_update_viewer_detail_popup_menu_select_all (GtkWidget *menuitem, gpointer us
 	while (valid) {
 		gtk_tree_model_get (model, &iter, GPK_UPDATES_COLUMN_INFO, &info, -1);
 		if (info != PK_INFO_ENUM_BLOCKED)
-			gtk_tree_store_set (GTK_TREE_STORE(model), &iter,
-					    GPK_UPDATES_COLUMN_SELECT, TRUE, -1);
+			gpk_update_viewer_set_selected (model, &iter, TRUE);
 
 		/* do for children too */
 		child_valid = gtk_tree_model_iter_children (model, &child_iter, &iter);
 		while (child_valid) {
-			gtk_tree_store_set (GTK_TREE_STORE(model), &child_iter,
-					    GPK_UPDATES_COLUMN_SELECT, TRUE, -1);
+			gpk_update_viewer_set_selected (model, &child_iter, TRUE);
 			child_valid = gtk_tree_model_iter_next (model, &child_iter);
 		}
 
@@ -2183,16 +2784,14 @@ gpk_update_viewer_detail_popup_menu_select_security (GtkWidget *menuitem, gpoint
 	while (valid) {
 		gtk_tree_model_get (model, &iter, GPK_UPDATES_COLUMN_INFO, &info, -1);
 		ret = (info == PK_INFO_ENUM_SECURITY);
-		gtk_tree_store_set (GTK_TREE_STORE(model), &iter,
-				    GPK_UPDATES_COLUMN_SELECT, ret, -1);
+		gpk_update_viewer_set_selected (model, &iter, ret);
 
 		/* do for children too */
 		child_valid = gtk_tree_model_iter_children (model, &child_iter, &iter);
 		while (child_valid) {
 			gtk_tree_model_get (model, &child_iter, GPK_UPDATES_COLUMN_INFO, &info, -1);
 			ret = (info == PK_INFO_ENUM_SECURITY);
-			gtk_tree_store_set (GTK_TREE_STORE(model), &child_iter,
-					    GPK_UPDATES_COLUMN_SELECT, ret, -1);
+			gpk_update_viewer_set_selected (model, &child_iter, ret);
 			child_valid = gtk_tree_model_iter_next (model, &child_iter);
 		}
 
@@ -2221,15 +2820,12 @@ gpk_update_viewer_detail_popup_menu_select_none (GtkWidget *menuitem, gpointer u
 	model = gtk_tree_view_get_model (treeview);
 	valid = gtk_tree_model_get_iter_first (model, &iter);
 	while (valid) {
-		gtk_tree_model_get (model, &iter, -1);
-		gtk_tree_store_set (GTK_TREE_STORE(model), &iter,
-				    GPK_UPDATES_COLUMN_SELECT, FALSE, -1);
+		gpk_update_viewer_set_selected (model, &iter, FALSE);
 
 		/* do for children too */
 		child_valid = gtk_tree_model_iter_children (model, &child_iter, &iter);
 		while (child_valid) {
-			gtk_tree_store_set (GTK_TREE_STORE(model), &child_iter,
-					    GPK_UPDATES_COLUMN_SELECT, FALSE, -1);
+			gpk_update_viewer_set_selected (model, &child_iter, FALSE);
 			child_valid = gtk_tree_model_iter_next (model, &child_iter);
 		}
 
@@ -2377,89 +2973,293 @@ gpk_update_viewer_detail_button_pressed (GtkWidget *treeview, GdkEventButton *ev
 	return TRUE;
 }
 
-/**
- * gpk_update_viewer_detail_popup_menu:
- **/
-static gboolean
-gpk_update_viewer_detail_popup_menu (GtkWidget *treeview, gpointer user_data)
-{
-	gpk_update_viewer_detail_popup_menu_create (treeview, NULL, NULL);
-	return TRUE;
+/**
+ * gpk_update_viewer_detail_popup_menu:
+ **/
+static gboolean
+gpk_update_viewer_detail_popup_menu (GtkWidget *treeview, gpointer user_data)
+{
+	gpk_update_viewer_detail_popup_menu_create (treeview, NULL, NULL);
+	return TRUE;
+}
+
+/**
+ * gpk_update_viewer_set_known_details:
+ *
+ * Uses what was known about a package the last time, until PackageKit
+ * answers again.
+ **/
+static void
+gpk_update_viewer_set_known_details (GtkTreeIter *iter, GpkUpdateSnapshotItem *known)
+{
+	PkUpdateDetail *update_detail = NULL;
+
+	if (known->update_text != NULL) {
+		update_detail = g_object_new (PK_TYPE_UPDATE_DETAIL,
+					      "package-id", known->package_id,
+					      "update-text", known->update_text,
+					      "restart", known->restart,
+					      NULL);
+	}
+
+	gtk_tree_store_set (array_store_updates, iter,
+			    GPK_UPDATES_COLUMN_SIZE, (gint) known->size,
+			    GPK_UPDATES_COLUMN_SIZE_DISPLAY, (gint) known->size,
+			    GPK_UPDATES_COLUMN_RESTART, known->restart,
+			    GPK_UPDATES_COLUMN_UPDATE_DETAIL_OBJ, update_detail,
+			    -1);
+}
+
+/**
+ * gpk_update_viewer_add_update:
+ **/
+static void
+gpk_update_viewer_add_update (GtkTreeModel *model,
+			      const gchar *package_id,
+			      PkInfoEnum info,
+			      const gchar *summary,
+			      gboolean stale)
+{
+	GpkUpdateSnapshotItem *known = NULL;
+	GtkTreeIter iter;
+	GtkTreeIter parent;
+	gboolean selected;
+	gboolean sensitive;
+	gchar *text;
+
+	/* find our parent */
+	gpk_update_viewer_get_parent_for_info (info, &parent);
+
+	/* add to array store */
+	text = gpk_package_id_format_details (package_id, summary, TRUE);
+	g_debug ("adding: id=%s, text=%s", package_id, text);
+	selected = (info != PK_INFO_ENUM_BLOCKED);
+
+	/* only make the checkbox selectable if:
+	 *  - we can do UpdatePackages rather than just UpdateSystem
+	 *  - the update is not blocked
+	 *  - the list is not the one saved the last time
+	 */
+	sensitive = selected;
+	if (!pk_bitfield_contain (roles, PK_ROLE_ENUM_UPDATE_PACKAGES))
+		sensitive = FALSE;
+	if (stale)
+		sensitive = FALSE;
+
+	/* add to model */
+	gtk_tree_store_insert_with_values (array_store_updates, &iter, &parent, -1,
+					   GPK_UPDATES_COLUMN_TEXT, text,
+					   GPK_UPDATES_COLUMN_ID, package_id,
+					   GPK_UPDATES_COLUMN_INFO, info,
+					   GPK_UPDATES_COLUMN_SELECT, selected,
+					   GPK_UPDATES_COLUMN_SENSITIVE, sensitive,
+					   GPK_UPDATES_COLUMN_VISIBLE, TRUE,
+					   GPK_UPDATES_COLUMN_CLICKABLE, selected && !stale,
+					   GPK_UPDATES_COLUMN_RESTART, PK_RESTART_ENUM_NONE,
+					   GPK_UPDATES_COLUMN_STATUS, PK_INFO_ENUM_UNKNOWN,
+					   GPK_UPDATES_COLUMN_SIZE, 0,
+					   GPK_UPDATES_COLUMN_SIZE_DISPLAY, 0,
+					   GPK_UPDATES_COLUMN_DOWNLOAD_SIZE, 0,
+					   -1);
+	g_free (text);
+
+	/* the same version was in the last list */
+	if (snapshot_index != NULL)
+		known = g_hash_table_lookup (snapshot_index, package_id);
+	if (known != NULL)
+		gpk_update_viewer_set_known_details (&iter, known);
+
+	gpk_update_viewer_model_add_row (model, &iter, package_id);
+	gpk_update_viewer_selection_account (model, &iter, TRUE);
+}
+
+/**
+ * gpk_update_viewer_snapshot_free:
+ **/
+static void
+gpk_update_viewer_snapshot_free (void)
+{
+	update_list_stale = FALSE;
+	g_clear_pointer (&snapshot_index, g_hash_table_unref);
+	g_clear_pointer (&snapshot_items, g_ptr_array_unref);
+}
+
+/**
+ * gpk_update_viewer_snapshot_drop:
+ *
+ * Removes the list saved the last time when the current one could not be
+ * got, so it is not left disabled and shown as still checking.
+ **/
+static void
+gpk_update_viewer_snapshot_drop (void)
+{
+	if (!update_list_stale)
+		return;
+
+	gpk_update_viewer_snapshot_free ();
+	gpk_update_viewer_clear_updates ();
+	gpk_update_viewer_empty_stack_message (
+		/* TRANSLATORS: the list of updates could not be got */
+		_("Could not get updates"),
+		NULL,
+		FALSE);
+}
+
+/**
+ * gpk_update_viewer_snapshot_set:
+ *
+ * Keeps the known details of the updates, to fill the rows as added.
+ **/
+static void
+gpk_update_viewer_snapshot_set (GPtrArray *items)
+{
+	GpkUpdateSnapshotItem *item;
+	guint i;
+
+	g_clear_pointer (&snapshot_index, g_hash_table_unref);
+	g_clear_pointer (&snapshot_items, g_ptr_array_unref);
+
+	snapshot_items = items;
+	snapshot_index = g_hash_table_new (g_str_hash, g_str_equal);
+	for (i = 0; i < snapshot_items->len; i++) {
+		item = g_ptr_array_index (snapshot_items, i);
+		g_hash_table_insert (snapshot_index, item->package_id, item);
+	}
+}
+
+/**
+ * gpk_update_viewer_snapshot_show:
+ *
+ * Shows the list of updates saved the last time, marked as stale until
+ * the list from PackageKit replaces it.
+ **/
+static void
+gpk_update_viewer_snapshot_show (void)
+{
+	GpkUpdateSnapshotItem *item;
+	GPtrArray *items;
+	GtkTreeModel *model;
+	GtkTreeView *treeview;
+	GError *error = NULL;
+	guint i;
+
+	items = gpk_update_snapshot_load (NULL, &error);
+	if (items == NULL) {
+		g_debug ("no update snapshot: %s", error->message);
+		g_error_free (error);
+		return;
+	}
+	if (items->len == 0) {
+		g_ptr_array_unref (items);
+		return;
+	}
+
+	gpk_update_viewer_snapshot_set (items);
+	update_list_stale = TRUE;
+
+	treeview = GTK_TREE_VIEW(gtk_builder_get_object (builder, "treeview_updates"));
+	model = GTK_TREE_MODEL (array_store_updates);
+	g_object_ref (model);
+	gtk_tree_view_set_model (treeview, NULL);
+	for (i = 0; i < snapshot_items->len; i++) {
+		item = g_ptr_array_index (snapshot_items, i);
+		gpk_update_viewer_add_update (model, item->package_id, item->info, item->summary, TRUE);
+	}
+	gtk_tree_sortable_set_sort_column_id (GTK_TREE_SORTABLE (model),
+					      GPK_UPDATES_COLUMN_INFO,
+					      GTK_SORT_DESCENDING);
+	gtk_tree_view_set_model (treeview, model);
+	g_object_unref (model);
+	gtk_tree_view_expand_all (treeview);
+
+	gpk_update_viewer_reconsider_info ();
 }
 
 /**
- * gpk_update_viewer_packages_to_ids:
+ * gpk_update_viewer_snapshot_save:
+ *
+ * Saves the current list with its details, so it can be shown right away
+ * the next time.
  **/
-static gchar **
-gpk_update_viewer_packages_to_ids (GPtrArray *array)
+static void
+gpk_update_viewer_snapshot_save (void)
 {
+	GPtrArray *items;
+	GpkUpdateSnapshotItem *item;
+	GtkTreeIter iter;
+	GtkTreeModel *model;
+	GtkTreePath *path;
+	PkPackage *package;
+	PkUpdateDetail *update_detail;
+	GError *error = NULL;
+	guint size;
 	guint i;
-	gchar **value;
-	PkPackage *item;
-	const gchar *package_id;
 
-	value = g_new0 (gchar *, array->len + 1);
-	for (i = 0; i < array->len; i++) {
-		item = g_ptr_array_index (array, i);
-		package_id = pk_package_get_id (item);
-		value[i] = g_strdup (package_id);
+	if (update_array == NULL)
+		return;
+
+	model = GTK_TREE_MODEL (array_store_updates);
+	items = g_ptr_array_new_with_free_func ((GDestroyNotify) gpk_update_snapshot_item_free);
+	for (i = 0; i < update_array->len; i++) {
+		package = g_ptr_array_index (update_array, i);
+		item = gpk_update_snapshot_item_new (pk_package_get_id (package),
+						     pk_package_get_info (package),
+						     pk_package_get_summary (package));
+		g_ptr_array_add (items, item);
+
+		path = gpk_update_viewer_model_get_path (model, item->package_id);
+		if (path == NULL)
+			continue;
+		gtk_tree_model_get_iter (model, &iter, path);
+		gtk_tree_path_free (path);
+
+		gtk_tree_model_get (model, &iter,
+				    GPK_UPDATES_COLUMN_SIZE, &size,
+				    GPK_UPDATES_COLUMN_RESTART, &item->restart,
+				    GPK_UPDATES_COLUMN_UPDATE_DETAIL_OBJ, &update_detail,
+				    -1);
+		item->size = size;
+		if (update_detail != NULL)
+			item->update_text = g_strdup (pk_update_detail_get_update_text (update_detail));
 	}
-	return value;
+
+	if (!gpk_update_snapshot_save (items, &error)) {
+		g_warning ("failed to save the update snapshot: %s", error->message);
+		g_error_free (error);
+	}
+	g_ptr_array_unref (items);
 }
 
 /**
- * gpk_update_viewer_get_updates_cb:
+ * gpk_update_viewer_set_updates:
+ *
+ * Replaces the list with these updates, already sorted by name.
  **/
 static void
-gpk_update_viewer_get_updates_cb (PkClient *client, GAsyncResult *res, gpointer user_data)
+gpk_update_viewer_set_updates (GPtrArray *array)
 {
-	PkResults *results = NULL;
-	PkPackageSack *sack = NULL;
-	GError *error = NULL;
-	GPtrArray *array = NULL;
-	GPtrArray *array_messages = NULL;
 	PkPackage *item;
-	gchar *text = NULL;
-	gboolean selected;
-	gboolean sensitive;
-	GtkTreeIter iter;
-	GtkTreeIter parent;
 	guint i;
 	GtkTreeView *treeview;
 	GtkTreeModel *model;
 	GtkWidget *widget;
-	PkError *error_code = NULL;
-	GtkWindow *window;
 	PkInfoEnum info;
-	gchar **package_ids = NULL;
 	gchar *package_id = NULL;
 	gchar *summary = NULL;
 
-	/* get the results */
-	results = pk_client_generic_finish (client, res, &error);
-	if (results == NULL) {
-		/* TRANSLATORS: the PackageKit request did not complete, and it did not send an error */
-		gpk_update_viewer_error_dialog (_("Could not get updates"), NULL, error->message);
-		g_error_free (error);
-		goto out;
-	}
-
-	/* check error code */
-	error_code = pk_results_get_error_code (results);
-	if (error_code != NULL) {
-		g_warning ("failed to get updates: %s, %s", pk_error_enum_to_string (pk_error_get_code (error_code)), pk_error_get_details (error_code));
+	/* replace the list shown, saved the last time or from an earlier reply */
+	gpk_update_viewer_clear_updates ();
 
-		window = GTK_WINDOW(gtk_builder_get_object (builder, "dialog_updates"));
-		gpk_error_dialog_modal (window, gpk_error_enum_to_localised_text (pk_error_get_code (error_code)),
-					gpk_error_enum_to_localised_message (pk_error_get_code (error_code)), pk_error_get_details (error_code));
-		goto out;
-	}
+	/* build the model detached from the view and unsorted, so the view
+	 * is not updated and the store not re-sorted for every new row */
+	treeview = GTK_TREE_VIEW(gtk_builder_get_object (builder, "treeview_updates"));
+	model = GTK_TREE_MODEL (array_store_updates);
+	g_object_ref (model);
+	gtk_tree_view_set_model (treeview, NULL);
+	gtk_tree_sortable_set_sort_column_id (GTK_TREE_SORTABLE (model),
+					      GTK_TREE_SORTABLE_UNSORTED_SORT_COLUMN_ID,
+					      GTK_SORT_DESCENDING);
 
-	/* get data */
-	sack = pk_results_get_package_sack (results);
-	pk_package_sack_sort (sack, PK_PACKAGE_SACK_SORT_TYPE_NAME);
-	array = pk_package_sack_get_array (sack);
-	widget = GTK_WIDGET(gtk_builder_get_object (builder, "treeview_updates"));
 	for (i = 0; i < array->len; i++) {
 		item = g_ptr_array_index (array, i);
 
@@ -2470,38 +3270,7 @@ gpk_update_viewer_get_updates_cb (PkClient *client, GAsyncResult *res, gpointer
 			      "summary", &summary,
 			      NULL);
 
-		/* find our parent */
-		gpk_update_viewer_get_parent_for_info (info, &parent);
-
-		/* add to array store */
-		text = gpk_package_id_format_details (package_id, summary, TRUE);
-		g_debug ("adding: id=%s, text=%s", package_id, text);
-		selected = (info != PK_INFO_ENUM_BLOCKED);
-
-		/* only make the checkbox selectable if:
-		 *  - we can do UpdatePackages rather than just UpdateSystem
-		 *  - the update is not blocked
-		 */
-		sensitive = selected;
-		if (!pk_bitfield_contain (roles, PK_ROLE_ENUM_UPDATE_PACKAGES))
-			sensitive = FALSE;
-
-		/* add to model */
-		gtk_tree_store_append (array_store_updates, &iter, &parent);
-		gtk_tree_store_set (array_store_updates, &iter,
-				    GPK_UPDATES_COLUMN_TEXT, text,
-				    GPK_UPDATES_COLUMN_ID, package_id,
-				    GPK_UPDATES_COLUMN_INFO, info,
-				    GPK_UPDATES_COLUMN_SELECT, selected,
-				    GPK_UPDATES_COLUMN_SENSITIVE, sensitive,
-				    GPK_UPDATES_COLUMN_VISIBLE, TRUE,
-				    GPK_UPDATES_COLUMN_CLICKABLE, selected,
-				    GPK_UPDATES_COLUMN_RESTART, PK_RESTART_ENUM_NONE,
-				    GPK_UPDATES_COLUMN_STATUS, PK_INFO_ENUM_UNKNOWN,
-				    GPK_UPDATES_COLUMN_SIZE, 0,
-				    GPK_UPDATES_COLUMN_SIZE_DISPLAY, 0,
-				    -1);
-		g_free (text);
+		gpk_update_viewer_add_update (model, package_id, info, summary, FALSE);
 		g_free (package_id);
 		g_free (summary);
 	}
@@ -2509,32 +3278,24 @@ gpk_update_viewer_get_updates_cb (PkClient *client, GAsyncResult *res, gpointer
 	/* get the download sizes */
 	if (update_array != NULL)
 		g_ptr_array_unref (update_array);
-	update_array = pk_results_get_package_array (results);
+	update_array = g_ptr_array_ref (array);
 
-	/* sort by name */
-	treeview = GTK_TREE_VIEW(gtk_builder_get_object (builder, "treeview_updates"));
-	model = gtk_tree_view_get_model (treeview);
+	/* sort once by kind, the packages are already sorted by name */
 	gtk_tree_sortable_set_sort_column_id (GTK_TREE_SORTABLE (model),
 					      GPK_UPDATES_COLUMN_INFO,
 					      GTK_SORT_DESCENDING);
+	gtk_tree_view_set_model (treeview, model);
+	g_object_unref (model);
 	gtk_tree_view_expand_all (treeview);
 
-	/* get the download sizes */
-	if (update_array->len > 0) {
-		package_ids = gpk_update_viewer_packages_to_ids (array);
-
-		/* get the details of all the packages */
-		pk_client_get_update_detail_async (PK_CLIENT(task), package_ids, cancellable,
-						   (PkProgressCallback) gpk_update_viewer_progress_cb, NULL,
-						   (GAsyncReadyCallback) gpk_update_viewer_get_update_detail_cb, NULL);
+	/* the list is up to date */
+	gpk_update_viewer_snapshot_free ();
 
-		/* get the details of all the packages */
-		pk_client_get_details_async (PK_CLIENT(task), package_ids, cancellable,
-					     (PkProgressCallback) gpk_update_viewer_progress_cb, NULL,
-					     (GAsyncReadyCallback) gpk_update_viewer_get_details_cb, NULL);
-
-		g_strfreev (package_ids);
-	}
+	/* get the download sizes */
+	if (update_array->len > 0)
+		gpk_update_viewer_details_start ();
+	else
+		gpk_update_viewer_snapshot_save ();
 
 	/* are now able to do action */
 	widget = GTK_WIDGET(gtk_builder_get_object (builder, "button_install"));
@@ -2542,14 +3303,55 @@ gpk_update_viewer_get_updates_cb (PkClient *client, GAsyncResult *res, gpointer
 
 	/* set info */
 	gpk_update_viewer_reconsider_info ();
+}
+
+/**
+ * gpk_update_viewer_get_updates_cb:
+ **/
+static void
+gpk_update_viewer_get_updates_cb (PkClient *client, GAsyncResult *res, gpointer user_data)
+{
+	PkResults *results = NULL;
+	PkPackageSack *sack = NULL;
+	GError *error = NULL;
+	GPtrArray *array = NULL;
+	PkError *error_code = NULL;
+	GtkWindow *window;
+
+	/* get the results */
+	results = pk_client_generic_finish (client, res, &error);
+	if (results == NULL) {
+		/* TRANSLATORS: the PackageKit request did not complete, and it did not send an error */
+		gpk_update_viewer_error_dialog (_("Could not get updates"), NULL, error->message);
+		g_error_free (error);
+		gpk_update_viewer_snapshot_drop ();
+		goto out;
+	}
+
+	/* check error code */
+	error_code = pk_results_get_error_code (results);
+	if (error_code != NULL) {
+		g_warning ("failed to get updates: %s, %s", pk_error_enum_to_string (pk_error_get_code (error_code)), pk_error_get_details (error_code));
+
+		window = GTK_WINDOW(gtk_builder_get_object (builder, "dialog_updates"));
+		gpk_error_dialog_modal (window, gpk_error_enum_to_localised_text (pk_error_get_code (error_code)),
+					gpk_error_enum_to_localised_message (pk_error_get_code (error_code)), pk_error_get_details (error_code));
+		gpk_update_viewer_snapshot_drop ();
+		goto out;
+	}
+
+	/* get data */
+	sack = pk_results_get_package_sack (results);
+	pk_package_sack_sort (sack, PK_PACKAGE_SACK_SORT_TYPE_NAME);
+	array = pk_package_sack_get_array (sack);
+
+	gpk_update_viewer_set_updates (array);
 
 out:
 	if (error_code != NULL)
 		g_object_unref (error_code);
 	if (array != NULL)
 		g_ptr_array_unref (array);
-	if (array_messages != NULL)
-		g_ptr_array_unref (array_messages);
 	if (sack != NULL)
 		g_object_unref (sack);
 	if (results != NULL)
@@ -2557,29 +3359,190 @@ out:
 }
 
 /**
- * gpk_update_viewer_get_updates
+ * gpk_update_viewer_clear_updates:
  **/
 static void
-gpk_update_viewer_get_updates (void)
+gpk_update_viewer_clear_updates (void)
 {
-	gchar *text = NULL;
-	PkBitfield filter = PK_FILTER_ENUM_NONE;
-
 	/* clear all widgets */
+	gpk_update_viewer_details_stop ();
+	gpk_update_viewer_progress_clear ();
+	g_hash_table_remove_all (array_store_rows);
+	gpk_update_viewer_clear_headers ();
 	gtk_tree_store_clear (array_store_updates);
+	gpk_update_viewer_selection_reset ();
 	gtk_text_buffer_set_text (text_buffer, "", -1);
+}
 
+/**
+ * gpk_update_viewer_show_checking:
+ **/
+static void
+gpk_update_viewer_show_checking (void)
+{
+	/* keep showing the last list until the new one arrives */
+	if (update_list_stale)
+		return;
+
+	gpk_update_viewer_clear_updates ();
 	gpk_update_viewer_empty_stack_message (
 		/* TRANSLATORS: this is the header */
 		_("Checking for updates…"),
 		NULL,
 		FALSE);
+}
+
+/**
+ * gpk_update_viewer_get_updates
+ **/
+static void
+gpk_update_viewer_get_updates (void)
+{
+	PkBitfield filter = PK_FILTER_ENUM_NONE;
+
+	gpk_update_viewer_show_checking ();
 
 	/* get new array */
 	pk_client_get_updates_async (PK_CLIENT(task), filter, cancellable,
 				     (PkProgressCallback) gpk_update_viewer_progress_cb, NULL,
 				     (GAsyncReadyCallback) gpk_update_viewer_get_updates_cb, NULL);
-	g_free (text);
+}
+
+/**
+ * gpk_update_viewer_get_shared_updates_cb:
+ **/
+static void
+gpk_update_viewer_get_shared_updates_cb (GObject *object, GAsyncResult *res, gpointer user_data)
+{
+	GVariant *result = NULL;
+	GVariant *records = NULL;
+	GPtrArray *items = NULL;
+	GPtrArray *array = NULL;
+	PkPackageSack *sack = NULL;
+	PkPackage *package;
+	GpkUpdateSnapshotItem *item;
+	GError *error = NULL;
+	gint64 timestamp = 0;
+	guint i;
+
+	result = g_dbus_connection_call_finish (G_DBUS_CONNECTION (object), res, &error);
+	if (result == NULL) {
+		if (g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED)) {
+			g_error_free (error);
+			return;
+		}
+		g_debug ("no updates from the software service: %s", error->message);
+		g_error_free (error);
+		service_available = FALSE;
+		gpk_update_viewer_get_updates ();
+		return;
+	}
+
+	/* the service has not checked for updates yet */
+	g_variant_get (result, "(x@a" GPK_UPDATE_SNAPSHOT_RECORD ")", &timestamp, &records);
+	if (timestamp == 0) {
+		g_debug ("the software service has no updates list yet");
+		service_available = FALSE;
+		gpk_update_viewer_get_updates ();
+		goto out;
+	}
+	service_available = TRUE;
+
+	items = gpk_update_snapshot_from_variant (records);
+	sack = pk_package_sack_new ();
+	for (i = 0; i < items->len; i++) {
+		item = g_ptr_array_index (items, i);
+		package = pk_package_new ();
+		if (!pk_package_set_id (package, item->package_id, &error)) {
+			g_warning ("invalid update %s: %s", item->package_id, error->message);
+			g_clear_error (&error);
+			g_object_unref (package);
+			continue;
+		}
+		pk_package_set_info (package, item->info);
+		pk_package_set_summary (package, item->summary);
+		pk_package_sack_add_package (sack, package);
+		g_object_unref (package);
+	}
+	pk_package_sack_sort (sack, PK_PACKAGE_SACK_SORT_TYPE_NAME);
+	array = pk_package_sack_get_array (sack);
+
+	/* fill the rows with the details known by the service */
+	gpk_update_viewer_snapshot_set (items);
+	gpk_update_viewer_set_updates (array);
+
+out:
+	if (array != NULL)
+		g_ptr_array_unref (array);
+	if (sack != NULL)
+		g_object_unref (sack);
+	if (records != NULL)
+		g_variant_unref (records);
+	g_variant_unref (result);
+}
+
+/**
+ * gpk_update_viewer_get_shared_updates:
+ *
+ * Gets the updates found by xings-software-service, so PackageKit is not
+ * asked again, and only falls back to PackageKit when it is not running.
+ **/
+static void
+gpk_update_viewer_get_shared_updates (void)
+{
+	if (service_connection == NULL) {
+		gpk_update_viewer_get_updates ();
+		return;
+	}
+
+	gpk_update_viewer_show_checking ();
+
+	g_dbus_connection_call (service_connection,
+				GPK_UPDATES_DBUS_NAME,
+				GPK_UPDATES_DBUS_PATH,
+				GPK_UPDATES_DBUS_INTERFACE,
+				"GetUpdates",
+				NULL,
+				G_VARIANT_TYPE ("(xa" GPK_UPDATE_SNAPSHOT_RECORD ")"),
+				G_DBUS_CALL_FLAGS_NO_AUTO_START,
+				GPK_UPDATE_VIEWER_SERVICE_TIMEOUT,
+				cancellable,
+				gpk_update_viewer_get_shared_updates_cb,
+				NULL);
+}
+
+/**
+ * gpk_update_viewer_service_vanished_cb:
+ **/
+static void
+gpk_update_viewer_service_vanished_cb (GDBusConnection *connection,
+				       const gchar *name,
+				       gpointer user_data)
+{
+	/* nobody checks again when PackageKit says the updates changed */
+	if (service_available)
+		g_debug ("the software service exited");
+	service_available = FALSE;
+}
+
+/**
+ * gpk_update_viewer_shared_updates_changed_cb:
+ **/
+static void
+gpk_update_viewer_shared_updates_changed_cb (GDBusConnection *connection,
+					     const gchar *sender_name,
+					     const gchar *object_path,
+					     const gchar *interface_name,
+					     const gchar *signal_name,
+					     GVariant *parameters,
+					     gpointer user_data)
+{
+	g_debug ("shared updates changed");
+	if (ignore_updates_changed) {
+		g_debug ("ignoring");
+		return;
+	}
+	gpk_update_viewer_get_shared_updates ();
 }
 
 
@@ -2589,7 +3552,19 @@ gpk_updates_viewer_validate_cache_cb (GObject      *object,
                                       GAsyncResult *res,
                                       gpointer      user_data)
 {
-	last_resfreh_ago = pk_control_get_time_since_action_finish (control, res, NULL);
+	GError *error = NULL;
+	guint seconds_ago;
+
+	seconds_ago = pk_control_get_time_since_action_finish (control, res, &error);
+	if (error != NULL) {
+		if (!g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED))
+			g_warning ("failed to get the time since the last refresh: %s", error->message);
+		g_error_free (error);
+		return;
+	}
+
+	/* keep it locally, so the label can follow without asking again */
+	last_refresh_time = g_get_monotonic_time () - (gint64) seconds_ago * G_USEC_PER_SEC;
 
 	gpk_updates_viewer_refresh_cache_done ();
 }
@@ -2600,14 +3575,33 @@ gpk_updates_viewer_validate_cache_cb (GObject      *object,
 static void
 gpk_updates_viewer_validate_cache (void)
 {
+	/* already known, and only changed by a refresh */
+	if (last_refresh_time != 0) {
+		gpk_updates_viewer_refresh_cache_done ();
+		return;
+	}
+
 	/* get the time since the last refresh */
 	pk_control_get_time_since_action_async (control,
 	                                        PK_ROLE_ENUM_REFRESH_CACHE,
-	                                        NULL,
+	                                        cancellable,
 	                                        (GAsyncReadyCallback) gpk_updates_viewer_validate_cache_cb,
 	                                        NULL);
 }
 
+/**
+ * gpk_updates_viewer_invalidate_cache:
+ *
+ * Forgets the time of the last refresh, after the cache was refreshed.
+ **/
+static void
+gpk_updates_viewer_invalidate_cache (void)
+{
+	last_refresh_time = 0;
+	if (last_refresh_shown)
+		gpk_updates_viewer_validate_cache ();
+}
+
 /**
  * gpk_update_viewer_refresh_cache_cb
  **/
@@ -2649,6 +3643,7 @@ gpk_update_viewer_refresh_cache_cb (GObject      *object,
 	}
 
 	g_debug ("cache was updated.");
+	gpk_updates_viewer_invalidate_cache ();
 }
 
 /**
@@ -2848,12 +3843,21 @@ gpk_update_viewer_textview_visibility_notify_event (GtkWidget *text_view, GdkEve
 static void
 gpk_update_viewer_updates_changed_cb (PkControl *_control, gpointer user_data)
 {
+	/* the cache may have been refreshed by someone else */
+	gpk_updates_viewer_invalidate_cache ();
+
 	/* now try to get newest update array */
 	g_debug ("updates changed");
 	if (ignore_updates_changed) {
 		g_debug ("ignoring");
 		return;
 	}
+
+	/* the service checks again, and tells when the list is ready */
+	if (service_available) {
+		g_debug ("waiting for the software service");
+		return;
+	}
 	gpk_update_viewer_get_updates ();
 }
 
@@ -2891,8 +3895,21 @@ gpk_update_viewer_search_equal_func (GtkTreeModel *model, gint column, const gch
 static void
 gpk_update_viewer_notify_network_state_cb (PkControl *_control, GParamSpec *pspec, gpointer user_data)
 {
+	PkNetworkEnum state;
+	gboolean first;
+
 	gpk_update_viewer_check_mobile_broadband ();
-	gpk_update_viewer_get_updates ();
+
+	/* the list was already asked for on startup */
+	g_object_get (_control, "network-state", &state, NULL);
+	first = (network_state == PK_NETWORK_ENUM_UNKNOWN);
+	if (state == network_state)
+		return;
+	network_state = state;
+	if (first)
+		return;
+
+	gpk_update_viewer_get_shared_updates ();
 }
 
 /**
@@ -2924,6 +3941,7 @@ gpk_update_viewer_application_startup_cb (GtkApplication *_application, gpointer
 	restart_update = PK_RESTART_ENUM_NONE;
 
 	settings = g_settings_new (GPK_SETTINGS_SCHEMA);
+	download_rate = g_settings_get_uint (settings, GPK_SETTINGS_DOWNLOAD_RATE);
 	session = gpk_session_new ();
 	cancellable = g_cancellable_new ();
 
@@ -2969,10 +3987,17 @@ gpk_update_viewer_application_startup_cb (GtkApplication *_application, gpointer
 	                                          G_TYPE_BOOLEAN,  // GPK_UPDATES_COLUMN_PREPARED
 	                                          G_TYPE_UINT,     // GPK_UPDATES_COLUMN_SIZE
 	                                          G_TYPE_UINT,     // GPK_UPDATES_COLUMN_SIZE_DISPLAY
+	                                          G_TYPE_UINT,     // GPK_UPDATES_COLUMN_DOWNLOAD_SIZE
 	                                          G_TYPE_UINT,     // GPK_UPDATES_COLUMN_STATUS
 	                                          G_TYPE_POINTER,  // GPK_UPDATES_COLUMN_DETAILS_OBJ
 	                                          G_TYPE_POINTER,  // GPK_UPDATES_COLUMN_UPDATE_DETAIL_OBJ
 	                                          G_TYPE_BOOLEAN); // GPK_UPDATES_COLUMN_VISIBLE
+	array_store_rows = g_hash_table_new_full (g_str_hash, g_str_equal,
+	                                          g_free, (GDestroyNotify) gtk_tree_row_reference_free);
+	progress_queue = g_ptr_array_new_with_free_func ((GDestroyNotify) gpk_update_viewer_progress_free);
+	progress_pending = g_hash_table_new (g_str_hash, g_str_equal);
+	details_queue = g_ptr_array_new_with_free_func (g_free);
+	details_pending = g_hash_table_new (g_str_hash, g_str_equal);
 
 	text_buffer = gtk_text_buffer_new (NULL);
 	gtk_text_buffer_create_tag (text_buffer, "para",
@@ -3075,6 +4100,33 @@ gpk_update_viewer_application_startup_cb (GtkApplication *_application, gpointer
 	gtk_box_pack_start (GTK_BOX(widget), info_mobile, FALSE, FALSE, 3);
 	gtk_box_reorder_child (GTK_BOX(widget), info_mobile, 1);
 
+	/* follow the updates found by xings-software-service */
+	service_connection = g_application_get_dbus_connection (G_APPLICATION (application));
+	if (service_connection != NULL) {
+		g_object_ref (service_connection);
+		service_signal_id =
+			g_dbus_connection_signal_subscribe (service_connection,
+							    GPK_UPDATES_DBUS_NAME,
+							    GPK_UPDATES_DBUS_INTERFACE,
+							    "UpdatesChanged",
+							    GPK_UPDATES_DBUS_PATH,
+							    NULL,
+							    G_DBUS_SIGNAL_FLAGS_NONE,
+							    gpk_update_viewer_shared_updates_changed_cb,
+							    NULL, NULL);
+		service_watch_id =
+			g_bus_watch_name_on_connection (service_connection,
+							GPK_UPDATES_DBUS_NAME,
+							G_BUS_NAME_WATCHER_FLAGS_NONE,
+							NULL,
+							gpk_update_viewer_service_vanished_cb,
+							NULL, NULL);
+	}
+
+	/* show the last known updates while the current ones are asked */
+	gpk_update_viewer_snapshot_show ();
+	gpk_update_viewer_get_shared_updates ();
+
 	/* show window */
 	gtk_widget_show (main_window);
 }
@@ -3142,8 +4194,33 @@ main (int argc, char *argv[])
 
 	gpk_updates_viewer_stop_validate_cache ();
 
+	if (service_watch_id != 0)
+		g_bus_unwatch_name (service_watch_id);
+	if (service_connection != NULL) {
+		if (service_signal_id != 0)
+			g_dbus_connection_signal_unsubscribe (service_connection, service_signal_id);
+		g_object_unref (service_connection);
+	}
+	if (details_cancellable != NULL) {
+		g_cancellable_cancel (details_cancellable);
+		g_object_unref (details_cancellable);
+	}
+	if (details_pending != NULL)
+		g_hash_table_unref (details_pending);
+	if (details_queue != NULL)
+		g_ptr_array_unref (details_queue);
+	if (progress_flush_id != 0)
+		g_source_remove (progress_flush_id);
+	if (progress_pending != NULL)
+		g_hash_table_unref (progress_pending);
+	if (progress_queue != NULL)
+		g_ptr_array_unref (progress_queue);
 	if (update_array != NULL)
 		g_ptr_array_unref (update_array);
+	gpk_update_viewer_snapshot_free ();
+	gpk_update_viewer_clear_headers ();
+	if (array_store_rows != NULL)
+		g_hash_table_unref (array_store_rows);
 	if (array_store_updates != NULL)
 		g_object_unref (array_store_updates);
 	if (builder != NULL)
@@ -49,6 +49,7 @@
 #include "gpk-as-store.h"
 #include "gpk-backend.h"
 #include "gpk-categories.h"
+#include "gpk-icon-loader.h"
 #include "gpk-packages-list.h"
 
 typedef enum {
@@ -70,13 +71,22 @@ typedef struct {
 
 	GpkBackend		*backend;
 	GCancellable		*cancellable;
+	GCancellable		*refresh_cancellable;
 
 	gboolean		 has_package;
 	GtkListStore		*packages_store;
 
+	GpkIconLoader		*icon_loader;
+	GCancellable		*icons_cancellable;
+	GHashTable		*icons_pending;
+	GCancellable		*details_icon_cancellable;
+
 	gchar			*search_text;
 	gboolean		 search_in_progress;
 	GpkSearchType		 search_type;
+	GCancellable		*search_cancellable;
+	guint			 search_typeahead_id;
+	gchar			*search_category_waiting;
 
 	GpkPackageView		 package_view;
 	gchar			*selection_id;
@@ -88,6 +98,11 @@ typedef struct {
 	GSettings		*settings;
 } GpkApplicationPrivate;
 
+typedef struct {
+	GpkApplicationPrivate	*priv;
+	GCancellable		*cancellable;
+} GpkApplicationSearch;
+
 
 static void gpk_application_remove_packages_cb (PkTask *task, GAsyncResult *res, GpkApplicationPrivate *priv);
 static void gpk_application_install_packages_cb (PkTask *task, GAsyncResult *res, GpkApplicationPrivate *priv);
@@ -128,38 +143,39 @@ gpk_get_icon_name_from_component (AsComponent *component)
 	return icon_name;
 }
 
-static GdkPixbuf *
-gpk_get_pixbuf_from_component (AsComponent *component, gint size)
+/**
+ * gpk_get_icon_filename_from_component:
+ *
+ * Choose the smallest local icon that is not scaled up, or the biggest one.
+ **/
+static const gchar *
+gpk_get_icon_filename_from_component (AsComponent *component, gint size)
 {
 	GPtrArray *icons = NULL;
-	AsIcon *icon = NULL;
-	GdkPixbuf *pixbuf = NULL, *scaled_pixbuf = NULL;
-	const gchar *filename = NULL;
+	AsIcon *icon = NULL, *best = NULL;
 	guint i = 0;
 
 	icons = as_component_get_icons(component);
 	for (i = 0; i < icons->len; i++) {
 		icon = AS_ICON (g_ptr_array_index (icons, i));
-		if (as_icon_get_kind (icon) == AS_ICON_KIND_LOCAL ||
-		    as_icon_get_kind (icon) == AS_ICON_KIND_CACHED) {
-			filename = as_icon_get_filename (icon);
-			if (!filename) continue;
-
-			pixbuf = gdk_pixbuf_new_from_file (filename, NULL);
-			if (pixbuf) break;
+		if (as_icon_get_kind (icon) != AS_ICON_KIND_LOCAL &&
+		    as_icon_get_kind (icon) != AS_ICON_KIND_CACHED)
+			continue;
+		if (as_icon_get_filename (icon) == NULL)
+			continue;
+
+		if (best == NULL) {
+			best = icon;
+		} else if (as_icon_get_width (best) < (guint) size) {
+			if (as_icon_get_width (icon) > as_icon_get_width (best))
+				best = icon;
+		} else if (as_icon_get_width (icon) >= (guint) size &&
+		           as_icon_get_width (icon) < as_icon_get_width (best)) {
+			best = icon;
 		}
 	}
 
-	if (pixbuf) {
-		scaled_pixbuf = gdk_pixbuf_scale_simple (pixbuf,
-		                                         size,
-		                                         size,
-		                                         GDK_INTERP_BILINEAR);
-		g_object_unref (pixbuf);
-		pixbuf = scaled_pixbuf;
-	}
-
-	return pixbuf;
+	return best != NULL ? as_icon_get_filename (best) : NULL;
 }
 
 static GdkPixbuf *
@@ -478,83 +494,296 @@ gpk_application_button_remove_cb (GtkAction *action, GpkApplicationPrivate *priv
 static void
 gpk_application_clear_packages (GpkApplicationPrivate *priv)
 {
+	/* the pending icons are for the old rows */
+	g_cancellable_cancel (priv->icons_cancellable);
+	g_object_unref (priv->icons_cancellable);
+	priv->icons_cancellable = g_cancellable_new ();
+	g_hash_table_remove_all (priv->icons_pending);
+
 	/* clear existing array */
 	priv->has_package = FALSE;
 	gtk_list_store_clear (priv->packages_store);
 }
 
 /**
- * gpk_application_add_item_to_results:
+ * gpk_application_icon_loaded_cb:
  **/
 static void
-gpk_application_add_item_to_results (GpkApplicationPrivate *priv, PkPackage *item)
+gpk_application_icon_loaded_cb (GpkIconLoader       *loader,
+                                GAsyncResult        *res,
+                                GtkTreeRowReference *row)
+{
+	GdkPixbuf *pixbuf = NULL;
+	GtkTreeModel *model;
+	GtkTreePath *path;
+	GtkTreeIter iter;
+	GError *error = NULL;
+
+	pixbuf = gpk_icon_loader_load_finish (loader, res, &error);
+	if (pixbuf == NULL) {
+		if (!g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED))
+			g_debug ("failed to load icon: %s", error->message);
+		g_error_free (error);
+		goto out;
+	}
+
+	/* the row could be removed in the meantime */
+	if (!gtk_tree_row_reference_valid (row))
+		goto out;
+
+	model = gtk_tree_row_reference_get_model (row);
+	path = gtk_tree_row_reference_get_path (row);
+	if (gtk_tree_model_get_iter (model, &iter, path)) {
+		gtk_list_store_set (GTK_LIST_STORE (model), &iter,
+		                    PACKAGES_COLUMN_PIXBUF, pixbuf,
+		                    -1);
+	}
+	gtk_tree_path_free (path);
+
+out:
+	if (pixbuf != NULL)
+		g_object_unref (pixbuf);
+	gtk_tree_row_reference_free (row);
+}
+
+/**
+ * gpk_application_get_component_icon:
+ *
+ * Get the cached icon of the component, or the stock one while the
+ * icon is loaded.
+ **/
+static GdkPixbuf *
+gpk_application_get_component_icon (GpkApplicationPrivate *priv,
+                                    GtkTreeModel          *model,
+                                    GtkTreeIter           *iter,
+                                    AsComponent           *component,
+                                    const gchar           *pending_id)
+{
+	GdkPixbuf *app_pixbuf = NULL;
+	GtkTreeRowReference *row = NULL;
+	GtkTreePath *path = NULL;
+	const gchar *filename = NULL;
+	const gchar *app_icon = NULL;
+	gboolean need_load = FALSE;
+
+	filename = gpk_get_icon_filename_from_component (component, 32);
+	if (filename != NULL) {
+		app_pixbuf = gpk_icon_loader_lookup (priv->icon_loader, filename, 32);
+		need_load = (app_pixbuf == NULL);
+	}
+
+	if (app_pixbuf == NULL) {
+		app_icon = gpk_get_icon_name_from_component (component);
+		if (app_icon != NULL)
+			app_pixbuf = gpk_get_pixbuf_from_icon_name (app_icon, 32);
+	}
+
+	/* the real icon is patched when it is decoded */
+	if (need_load && !g_hash_table_contains (priv->icons_pending, pending_id)) {
+		g_hash_table_add (priv->icons_pending, g_strdup (pending_id));
+
+		path = gtk_tree_model_get_path (model, iter);
+		row = gtk_tree_row_reference_new (model, path);
+		gtk_tree_path_free (path);
+
+		gpk_icon_loader_load_async (priv->icon_loader,
+		                            as_component_get_id (component),
+		                            filename, 32,
+		                            priv->icons_cancellable,
+		                            (GAsyncReadyCallback) gpk_application_icon_loaded_cb,
+		                            row);
+	}
+
+	return app_pixbuf;
+}
+
+/**
+ * gpk_application_get_item_icon:
+ *
+ * Get the cached icon, or a placeholder while the icon is loaded.
+ **/
+static GdkPixbuf *
+gpk_application_get_item_icon (GpkApplicationPrivate *priv,
+                               GtkTreeModel          *model,
+                               GtkTreeIter           *iter,
+                               PkPackage             *package)
 {
 	AsComponent *component = NULL;
 	GdkPixbuf *app_pixbuf = NULL;
-	GtkTreeIter iter;
-	gchar *text, *app_icon = NULL;
-	PkInfoEnum info;
-	gchar *package_id = NULL;
-	gchar *package_name = NULL;
-	gchar *summary = NULL;
 
-	/* get data */
-	g_object_get (item,
-		      "info", &info,
-		      "package-id", &package_id,
-		      "summary", &summary,
-		      NULL);
+	component = gpk_backend_get_component_by_pkgname (priv->backend, pk_package_get_name (package));
+	if (component != NULL)
+		app_pixbuf = gpk_application_get_component_icon (priv, model, iter, component, pk_package_get_id (package));
 
-	/* mark as got so we don't warn */
-	priv->has_package = TRUE;
+	if (app_pixbuf == NULL)
+		app_pixbuf = gpk_get_pixbuf_from_icon_name (gpk_info_enum_to_icon_name (pk_package_get_info (package)), 32);
+
+	return app_pixbuf;
+}
+
+/**
+ * gpk_application_packages_pixbuf_data_func:
+ *
+ * The icons of the packages are only searched when the row is shown.
+ **/
+static void
+gpk_application_packages_pixbuf_data_func (GtkTreeViewColumn     *column,
+                                           GtkCellRenderer       *renderer,
+                                           GtkTreeModel          *model,
+                                           GtkTreeIter           *iter,
+                                           GpkApplicationPrivate *priv)
+{
+	AsComponent *component = NULL;
+	GdkPixbuf *pixbuf = NULL;
+	PkPackage *package = NULL;
+	gchar *pkgname = NULL;
+
+	gtk_tree_model_get (model, iter,
+	                    PACKAGES_COLUMN_PIXBUF, &pixbuf,
+	                    PACKAGES_COLUMN_PACKAGE, &package,
+	                    PACKAGES_COLUMN_PKGNAME, &pkgname,
+	                    -1);
+
+	if (pixbuf == NULL && package != NULL) {
+		pixbuf = gpk_application_get_item_icon (priv, model, iter, package);
+	} else if (pixbuf == NULL && pkgname != NULL) {
+		component = gpk_backend_get_component_by_pkgname (priv->backend, pkgname);
+		if (component != NULL)
+			pixbuf = gpk_application_get_component_icon (priv, model, iter, component, pkgname);
+		if (pixbuf == NULL)
+			pixbuf = gpk_get_pixbuf_from_icon_name ("application-x-executable", 32);
+	}
 
-	/* are we in the package array? */
+	g_object_set (renderer, "pixbuf", pixbuf, NULL);
 
-	gtk_list_store_append (priv->packages_store, &iter);
+	if (pixbuf != NULL)
+		g_object_unref (pixbuf);
+	if (package != NULL)
+		g_object_unref (package);
+	g_free (pkgname);
+}
 
-	package_name = gpk_package_id_get_name (package_id);
-	component = gpk_backend_get_component_by_pkgname (priv->backend, package_name);
-	if (component) {
-		app_pixbuf = gpk_get_pixbuf_from_component (component, 32);
-		if (!app_pixbuf) {
-			app_icon = gpk_get_icon_name_from_component (component);
-			if (app_icon)
-				app_pixbuf = gpk_get_pixbuf_from_icon_name (app_icon, 32);
+/**
+ * gpk_application_packages_text_data_func:
+ *
+ * The markup of the packages is only formatted when the row is shown.
+ **/
+static void
+gpk_application_packages_text_data_func (GtkTreeViewColumn     *column,
+                                         GtkCellRenderer       *renderer,
+                                         GtkTreeModel          *model,
+                                         GtkTreeIter           *iter,
+                                         GpkApplicationPrivate *priv)
+{
+	AsComponent *component = NULL;
+	PkPackage *package = NULL;
+	gchar *text = NULL, *pkgname = NULL;
+
+	gtk_tree_model_get (model, iter,
+	                    PACKAGES_COLUMN_TEXT, &text,
+	                    PACKAGES_COLUMN_PACKAGE, &package,
+	                    PACKAGES_COLUMN_PKGNAME, &pkgname,
+	                    -1);
+
+	if (text == NULL && package == NULL && pkgname != NULL) {
+		component = gpk_backend_get_component_by_pkgname (priv->backend, pkgname);
+		if (component != NULL) {
+			text = gpk_common_format_details (as_component_get_name (component),
+			                                  as_component_get_summary (component),
+			                                  TRUE);
 		}
+	}
 
-		if (!app_pixbuf) {
-			app_pixbuf = gpk_get_pixbuf_from_icon_name (gpk_info_enum_to_icon_name (info), 32);
+	if (text == NULL && package != NULL) {
+		component = gpk_backend_get_component_by_pkgname (priv->backend, pk_package_get_name (package));
+		if (component != NULL) {
+			text = gpk_common_format_details (as_component_get_name (component),
+			                                  as_component_get_summary (component),
+			                                  TRUE);
+		} else {
+			text = gpk_package_id_format_details (pk_package_get_id (package),
+			                                      pk_package_get_summary (package),
+			                                      TRUE);
 		}
-
-		text = gpk_common_format_details (as_component_get_name (component),
-		                                  as_component_get_summary (component),
-		                                  TRUE);
-		gtk_list_store_set (priv->packages_store, &iter,
-		                    PACKAGES_COLUMN_PIXBUF, app_pixbuf,
-		                    PACKAGES_COLUMN_TEXT, text,
-		                    PACKAGES_COLUMN_SUMMARY, summary,
-		                    PACKAGES_COLUMN_ID, package_id,
-		                    PACKAGES_COLUMN_APP_NAME, as_component_get_name (component),
-		                    -1);
-	} else {
-		app_pixbuf = gpk_get_pixbuf_from_icon_name (gpk_info_enum_to_icon_name (info), 32);
-		text = gpk_package_id_format_details (package_id,
-		                                      summary,
-		                                      TRUE);
-		gtk_list_store_set (priv->packages_store, &iter,
-		                    PACKAGES_COLUMN_PIXBUF, app_pixbuf,
-		                    PACKAGES_COLUMN_TEXT, text,
-		                    PACKAGES_COLUMN_SUMMARY, summary,
-		                    PACKAGES_COLUMN_ID, package_id,
-		                    PACKAGES_COLUMN_APP_NAME, NULL,
-		                    -1);
 	}
 
-	g_object_unref (app_pixbuf);
-	g_free (package_id);
-	g_free (package_name);
-	g_free (summary);
+	g_object_set (renderer, "markup", text, NULL);
+
 	g_free (text);
+	g_free (pkgname);
+	if (package != NULL)
+		g_object_unref (package);
+}
+
+/**
+ * gpk_application_add_item_to_results:
+ **/
+static void
+gpk_application_add_item_to_results (GpkApplicationPrivate *priv, PkPackage *item)
+{
+	AsComponent *component = NULL;
+	const gchar *app_name = NULL;
+	GBytes *sort_key = NULL;
+
+	/* mark as got so we don't warn */
+	priv->has_package = TRUE;
+
+	/* the name is needed to sort, the rest is formatted when shown */
+	component = gpk_backend_get_component_by_pkgname (priv->backend, pk_package_get_name (item));
+	if (component != NULL)
+		app_name = as_component_get_name (component);
+
+	sort_key = gpk_packages_list_sort_key_new (FALSE, FALSE, FALSE, app_name, pk_package_get_id (item));
+
+	gtk_list_store_insert_with_values (priv->packages_store, NULL, -1,
+	                                   PACKAGES_COLUMN_SUMMARY, pk_package_get_summary (item),
+	                                   PACKAGES_COLUMN_ID, pk_package_get_id (item),
+	                                   PACKAGES_COLUMN_APP_NAME, app_name,
+	                                   PACKAGES_COLUMN_PACKAGE, item,
+	                                   PACKAGES_COLUMN_SORT_KEY, sort_key,
+	                                   -1);
+
+	g_bytes_unref (sort_key);
+}
+
+/**
+ * gpk_application_add_components_to_results:
+ *
+ * Show what AppStream knows about the packages while PackageKit resolves
+ * them. These rows are only informative, so they cannot be selected.
+ **/
+static void
+gpk_application_add_components_to_results (GpkApplicationPrivate *priv, gchar **pkgnames)
+{
+	AsComponent *component = NULL;
+	GBytes *sort_key = NULL;
+	GtkWidget *widget;
+	const gchar *app_name = NULL;
+	guint i;
+
+	widget = GTK_WIDGET (gtk_builder_get_object (priv->builder, "treeview_packages"));
+	gtk_tree_view_set_model (GTK_TREE_VIEW (widget), NULL);
+
+	for (i = 0; pkgnames[i] != NULL; i++) {
+		component = gpk_backend_get_component_by_pkgname (priv->backend, pkgnames[i]);
+		if (component == NULL)
+			continue;
+
+		/* the text and the icon are made when shown */
+		app_name = as_component_get_name (component);
+		sort_key = gpk_packages_list_sort_key_new (FALSE, FALSE, FALSE, app_name, pkgnames[i]);
+
+		gtk_list_store_insert_with_values (priv->packages_store, NULL, -1,
+		                                   PACKAGES_COLUMN_PKGNAME, pkgnames[i],
+		                                   PACKAGES_COLUMN_APP_NAME, app_name,
+		                                   PACKAGES_COLUMN_SORT_KEY, sort_key,
+		                                   -1);
+
+		g_bytes_unref (sort_key);
+	}
+
+	gtk_tree_view_set_model (GTK_TREE_VIEW (widget),
+	                         GTK_TREE_MODEL (priv->packages_store));
 }
 
 /**
@@ -566,7 +795,7 @@ gpk_application_suggest_better_search (GpkApplicationPrivate *priv)
 	const gchar *message = NULL;
 	/* TRANSLATORS: no results were found for this search */
 	const gchar *title = _("No results were found.");
-	GtkTreeIter iter;
+	GBytes *sort_key = NULL;
 	gchar *text;
 
 	if (priv->search_type == GPK_SEARCH_APP) {
@@ -578,13 +807,15 @@ gpk_application_suggest_better_search (GpkApplicationPrivate *priv)
 	}
 
 	text = g_strdup_printf ("%s\n%s", title, message);
-	gtk_list_store_append (priv->packages_store, &iter);
-	gtk_list_store_set (priv->packages_store, &iter,
-			    PACKAGES_COLUMN_TEXT, text,
-			    PACKAGES_COLUMN_PIXBUF, gpk_get_pixbuf_from_icon_name ("system-search", 32),
-			    PACKAGES_COLUMN_ID, NULL,
-			    PACKAGES_COLUMN_APP_NAME, NULL,
-			    -1);
+	sort_key = gpk_packages_list_sort_key_new (FALSE, FALSE, FALSE, NULL, NULL);
+	gtk_list_store_insert_with_values (priv->packages_store, NULL, -1,
+	                                   PACKAGES_COLUMN_TEXT, text,
+	                                   PACKAGES_COLUMN_PIXBUF, gpk_get_pixbuf_from_icon_name ("system-search", 32),
+	                                   PACKAGES_COLUMN_ID, NULL,
+	                                   PACKAGES_COLUMN_APP_NAME, NULL,
+	                                   PACKAGES_COLUMN_SORT_KEY, sort_key,
+	                                   -1);
+	g_bytes_unref (sort_key);
 	g_free (text);
 }
 
@@ -662,19 +893,7 @@ static void
 gpk_application_cancel_cb (GtkWidget *button_widget, GpkApplicationPrivate *priv)
 {
 	g_cancellable_cancel (priv->cancellable);
-}
-
-/**
- * gpk_application_set_button_find_sensitivity:
- **/
-static void
-gpk_application_set_button_find_sensitivity (GpkApplicationPrivate *priv)
-{
-	GtkWidget *widget;
-
-	/* only sensitive if not in the middle of a search */
-	widget = GTK_WIDGET (gtk_builder_get_object (priv->builder, "entry_text"));
-	gtk_widget_set_sensitive (widget, !priv->search_in_progress);
+	g_cancellable_cancel (priv->search_cancellable);
 }
 
 /**
@@ -706,23 +925,121 @@ gpk_application_show_categories_entry (GtkWidget *button_widget, GpkApplicationP
 }
 
 
+/**
+ * gpk_application_search_cancel:
+ *
+ * The results of the search in progress, if any, are ignored from now.
+ **/
+static void
+gpk_application_search_cancel (GpkApplicationPrivate *priv)
+{
+	g_cancellable_cancel (priv->search_cancellable);
+	g_object_unref (priv->search_cancellable);
+	priv->search_cancellable = g_cancellable_new ();
+
+	g_clear_pointer (&priv->search_category_waiting, g_free);
+
+	priv->search_in_progress = FALSE;
+}
+
+/**
+ * gpk_application_search_new:
+ *
+ * Start a search, superseding the one in progress.
+ **/
+static GpkApplicationSearch *
+gpk_application_search_new (GpkApplicationPrivate *priv)
+{
+	GpkApplicationSearch *search;
+
+	gpk_application_search_cancel (priv);
+
+	search = g_new0 (GpkApplicationSearch, 1);
+	search->priv = priv;
+	search->cancellable = g_object_ref (priv->search_cancellable);
+
+	priv->search_in_progress = TRUE;
+
+	return search;
+}
+
+static void
+gpk_application_search_free (GpkApplicationSearch *search)
+{
+	g_object_unref (search->cancellable);
+	g_free (search);
+}
+
+/**
+ * gpk_application_search_show_packages:
+ **/
+static void
+gpk_application_search_show_packages (GpkApplicationPrivate *priv, GPtrArray *array)
+{
+	PkPackage *item;
+	GtkWidget *widget;
+	guint i;
+
+	widget = GTK_WIDGET (gtk_builder_get_object (priv->builder, "treeview_packages"));
+	gtk_tree_view_set_model (GTK_TREE_VIEW (widget), NULL);
+
+	/* replace the rows shown from appstream while resolving */
+	gpk_application_clear_packages (priv);
+
+	/* all the results have the same height, so only the visible rows are measured */
+	gtk_tree_view_set_fixed_height_mode (GTK_TREE_VIEW (widget), TRUE);
+
+	/* get data */
+	for (i = 0; i < array->len; i++) {
+		item = g_ptr_array_index (array, i);
+		gpk_application_add_item_to_results (priv, item);
+	}
+
+	gtk_tree_view_set_model (GTK_TREE_VIEW (widget),
+	                         GTK_TREE_MODEL (priv->packages_store));
+
+	/* were there no entries found? */
+	if (!priv->has_package)
+		gpk_application_suggest_better_search (priv);
+
+	/* if there is an exact match, select it */
+	if (!_g_strzero (priv->selection_id)) {
+		gpk_application_select_exact_match (priv, priv->selection_id);
+	} else {
+		gpk_application_select_exact_match (priv, priv->search_text);
+	}
+
+	/* focus back to the text extry, without selecting what is being typed */
+	widget = GTK_WIDGET (gtk_builder_get_object (priv->builder, "entry_text"));
+	gtk_entry_grab_focus_without_selection (GTK_ENTRY (widget));
+}
+
 /**
  * gpk_application_search_cb:
  **/
 static void
-gpk_application_search_cb (PkClient *client, GAsyncResult *res, GpkApplicationPrivate *priv)
+gpk_application_search_cb (PkClient *client, GAsyncResult *res, GpkApplicationSearch *search)
 {
+	GpkApplicationPrivate *priv = search->priv;
 	PkResults *results;
 	GError *error = NULL;
 	PkError *error_code = NULL;
 	GPtrArray *array = NULL;
-	PkPackage *item;
-	guint i;
-	GtkWidget *widget;
 	GtkWindow *window;
 
 	/* get the results */
 	results = pk_client_generic_finish (client, res, &error);
+
+	/* a newer search took its place */
+	if (search->cancellable != priv->search_cancellable) {
+		g_debug ("ignoring superseded search");
+		if (error != NULL)
+			g_error_free (error);
+		goto out;
+	}
+
+	priv->search_in_progress = FALSE;
+
 	if (results == NULL) {
 		g_warning ("failed to search: %s", error->message);
 		g_error_free (error);
@@ -743,86 +1060,102 @@ gpk_application_search_cb (PkClient *client, GAsyncResult *res, GpkApplicationPr
 		goto out;
 	}
 
-	widget = GTK_WIDGET (gtk_builder_get_object (priv->builder, "treeview_packages"));
-	gtk_tree_view_set_model (GTK_TREE_VIEW (widget), NULL);
-
-	/* get data */
 	array = pk_results_get_package_array (results);
-	for (i = 0; i < array->len; i++) {
-		item = g_ptr_array_index (array, i);
-		gpk_application_add_item_to_results (priv, item);
-	}
+	gpk_application_search_show_packages (priv, array);
 
-	gtk_tree_view_set_model (GTK_TREE_VIEW (widget),
-	                         GTK_TREE_MODEL (priv->packages_store));
+out:
+	gpk_application_search_free (search);
 
-	/* were there no entries found? */
-	if (!priv->has_package)
-		gpk_application_suggest_better_search (priv);
+	if (error_code != NULL)
+		g_object_unref (error_code);
+	if (array != NULL)
+		g_ptr_array_unref (array);
+	if (results != NULL)
+		g_object_unref (results);
+}
 
-	/* if there is an exact match, select it */
-	if (!_g_strzero (priv->selection_id)) {
-		gpk_application_select_exact_match (priv, priv->selection_id);
-	} else {
-		gpk_application_select_exact_match (priv, priv->search_text);
+/**
+ * gpk_application_resolve_cb:
+ **/
+static void
+gpk_application_resolve_cb (GpkBackend *backend, GAsyncResult *res, GpkApplicationSearch *search)
+{
+	GpkApplicationPrivate *priv = search->priv;
+	GError *error = NULL;
+	GPtrArray *array = NULL;
+
+	array = gpk_backend_resolve_finish (backend, res, &error);
+
+	/* a newer search took its place */
+	if (search->cancellable != priv->search_cancellable) {
+		g_debug ("ignoring superseded search");
+		if (error != NULL)
+			g_error_free (error);
+		goto out;
 	}
 
-	/* focus back to the text extry */
-	widget = GTK_WIDGET (gtk_builder_get_object (priv->builder, "entry_text"));
-	gtk_widget_set_sensitive (widget, TRUE);
-	gtk_widget_grab_focus (widget);
+	priv->search_in_progress = FALSE;
+
+	if (array == NULL) {
+		g_warning ("failed to resolve: %s", error->message);
+		g_error_free (error);
+		goto out;
+	}
+
+	gpk_application_search_show_packages (priv, array);
 
 out:
-	/* mark find button sensitive */
-	priv->search_in_progress = FALSE;
-	gpk_application_set_button_find_sensitivity (priv);
+	gpk_application_search_free (search);
 
-	if (error_code != NULL)
-		g_object_unref (error_code);
 	if (array != NULL)
 		g_ptr_array_unref (array);
-	if (results != NULL)
-		g_object_unref (results);
 }
 
 static void
 gpk_application_search_app (GpkApplicationPrivate *priv, gchar *search_text)
 {
+	GpkApplicationSearch *search = NULL;
 	gchar **packages = NULL;
 
 	g_debug ("Searching appstream app: %s", search_text);
 
 	packages = gpk_backend_search_pkgnames_with_component (priv->backend, search_text);
-	pk_task_resolve_async (gpk_backend_get_task (priv->backend),
-	                       pk_bitfield_from_enums (PK_FILTER_ENUM_NEWEST,
-	                                               PK_FILTER_ENUM_ARCH,
-	                                               -1),
-	                       packages, priv->cancellable,
-	                       (PkProgressCallback) gpk_application_progress_cb, priv,
-	                       (GAsyncReadyCallback) gpk_application_search_cb, priv);
+
+	/* the names are known right now, the state of the packages is not */
+	gpk_application_add_components_to_results (priv, packages);
+
+	search = gpk_application_search_new (priv);
+	gpk_backend_resolve (priv->backend,
+	                     packages, search->cancellable,
+	                     (PkProgressCallback) gpk_application_progress_cb, priv,
+	                     (GAsyncReadyCallback) gpk_application_resolve_cb, search);
 
 	g_strfreev (packages);
 }
 
 static void
-gpk_application_search_categories (GpkApplicationPrivate *priv, gchar **categories)
+gpk_application_search_category (GpkApplicationPrivate *priv, const gchar *category_id)
 {
-	guint i = 0;
+	GpkApplicationSearch *search = NULL;
 	gchar **packages = NULL;
 
-	g_debug ("Searching appstream categories:");
-	for (i = 0; categories[i] != NULL; i++) {
-		g_debug (" - Category: %s", categories[i]);
+	g_debug ("Searching category: %s", category_id);
+
+	search = gpk_application_search_new (priv);
+
+	/* the categories are not indexed yet, so wait for the backend */
+	if (!gpk_backend_stage_is_finished (priv->backend, GPK_BACKEND_STAGE_CATEGORY_INDEX)) {
+		g_debug ("waiting for the category index");
+		priv->search_category_waiting = g_strdup (category_id);
+		gpk_application_search_free (search);
+		return;
 	}
 
-	packages = gpk_backend_search_pkgnames_by_categories (priv->backend, categories);
-	pk_task_resolve_async (gpk_backend_get_task (priv->backend),
-	                       pk_bitfield_from_enums (PK_FILTER_ENUM_NEWEST,
-	                                               PK_FILTER_ENUM_ARCH,
-	                                               -1),
-	                       packages, priv->cancellable,
-	                       (PkProgressCallback) gpk_application_progress_cb, priv,
-	                       (GAsyncReadyCallback) gpk_application_search_cb, priv);
+	packages = gpk_backend_get_category_pkgnames (priv->backend, category_id);
+	gpk_backend_resolve (priv->backend,
+	                     packages, search->cancellable,
+	                     (PkProgressCallback) gpk_application_progress_cb, priv,
+	                     (GAsyncReadyCallback) gpk_application_resolve_cb, search);
 
 	g_strfreev (packages);
 }
@@ -830,35 +1163,25 @@ gpk_application_search_categories (GpkApplicationPrivate *priv, gchar **categori
 static void
 gpk_application_search_pkgname (GpkApplicationPrivate *priv, gchar *search_text)
 {
+	GpkApplicationSearch *search = NULL;
 	gchar **tokens = NULL;
 
 	g_debug ("Searching by pkgname: %s", search_text);
 
 	tokens = g_strsplit (search_text, " ", -1);
 
+	search = gpk_application_search_new (priv);
 	pk_task_search_names_async (gpk_backend_get_task (priv->backend),
 	                            pk_bitfield_from_enums (PK_FILTER_ENUM_NEWEST,
 	                                                    PK_FILTER_ENUM_ARCH,
 	                                                    -1),
-	                            tokens, priv->cancellable,
+	                            tokens, search->cancellable,
 	                            (PkProgressCallback) gpk_application_progress_cb, priv,
-	                            (GAsyncReadyCallback) gpk_application_search_cb, priv);
+	                            (GAsyncReadyCallback) gpk_application_search_cb, search);
 
 	g_strfreev (tokens);
 }
 
-static void
-gpk_application_search_packages (GpkApplicationPrivate *priv, gchar **packages)
-{
-	pk_task_resolve_async (gpk_backend_get_task (priv->backend),
-	                       pk_bitfield_from_enums (PK_FILTER_ENUM_NEWEST,
-	                                               PK_FILTER_ENUM_ARCH,
-	                                               -1),
-	                       packages, priv->cancellable,
-	                       (PkProgressCallback) gpk_application_progress_cb, priv,
-	                       (GAsyncReadyCallback) gpk_application_search_cb, priv);
-}
-
 /**
  * gpk_application_perform_search:
  **/
@@ -867,10 +1190,6 @@ gpk_application_perform_search (GpkApplicationPrivate *priv)
 {
 	GtkEntry *entry;
 
-	/*if we are in the middle of a search, just return */
-	if (priv->search_in_progress == TRUE)
-		return;
-
 	g_debug ("CLEAR search");
 	gpk_application_clear_packages (priv);
 
@@ -882,18 +1201,12 @@ gpk_application_perform_search (GpkApplicationPrivate *priv)
 	/* have we got input? */
 	if (_g_strzero (priv->search_text)) {
 		g_debug ("no input");
+		gpk_application_search_cancel (priv);
 		return;
 	}
 
 	g_debug ("find %s", priv->search_text);
 
-	/* mark find button insensitive */
-	priv->search_in_progress = TRUE;
-	gpk_application_set_button_find_sensitivity (priv);
-
-	/* ensure new action succeeds */
-	g_cancellable_reset (priv->cancellable);
-
 	/* do the search */
 	if (priv->search_type == GPK_SEARCH_APP) {
 		gpk_application_search_app (priv, priv->search_text);
@@ -930,6 +1243,12 @@ gpk_application_restore_search (GpkApplicationPrivate *priv)
 static void
 gpk_application_search_entry_activated (GtkWidget *button_widget, GpkApplicationPrivate *priv)
 {
+	/* do not wait for the user to stop typing */
+	if (priv->search_typeahead_id > 0) {
+		g_source_remove (priv->search_typeahead_id);
+		priv->search_typeahead_id = 0;
+	}
+
 	gpk_application_perform_search (priv);
 }
 
@@ -968,6 +1287,14 @@ gpk_application_quit (GpkApplicationPrivate *priv)
 
 	/* we might have visual stuff running, close them down */
 	g_cancellable_cancel (priv->cancellable);
+	g_cancellable_cancel (priv->refresh_cancellable);
+	g_cancellable_cancel (priv->search_cancellable);
+	g_cancellable_cancel (priv->icons_cancellable);
+	g_cancellable_cancel (priv->details_icon_cancellable);
+	if (priv->search_typeahead_id > 0) {
+		g_source_remove (priv->search_typeahead_id);
+		priv->search_typeahead_id = 0;
+	}
 	g_application_release (G_APPLICATION (priv->application));
 
 	return TRUE;
@@ -987,14 +1314,50 @@ gpk_application_wm_close (GtkWidget             *widget,
 	return TRUE;
 }
 
+/**
+ * gpk_application_search_typeahead_cb:
+ **/
+static gboolean
+gpk_application_search_typeahead_cb (GpkApplicationPrivate *priv)
+{
+	GtkEntry *entry;
+	const gchar *text;
+
+	priv->search_typeahead_id = 0;
+
+	entry = GTK_ENTRY (gtk_builder_get_object (priv->builder, "entry_text"));
+	text = gtk_entry_get_text (entry);
+
+	/* too vague to search while typing, but it can be activated */
+	if (g_utf8_strlen (text, -1) < GPK_UI_SEARCH_TYPEAHEAD_MIN_LENGTH)
+		return FALSE;
+
+	/* these results are already shown or on the way */
+	if (priv->package_view == GPK_VIEW_SEARCH &&
+	    g_strcmp0 (text, priv->search_text) == 0)
+		return FALSE;
+
+	gpk_application_perform_search (priv);
+
+	return FALSE;
+}
+
 /**
  * gpk_application_text_changed_cb:
  **/
 static gboolean
 gpk_application_text_changed_cb (GtkEntry *entry, GpkApplicationPrivate *priv)
 {
-	/* mark find button sensitive */
-	gpk_application_set_button_find_sensitivity (priv);
+	/* search when the user stops typing */
+	if (priv->search_typeahead_id > 0)
+		g_source_remove (priv->search_typeahead_id);
+
+	priv->search_typeahead_id =
+		g_timeout_add (GPK_UI_SEARCH_TYPEAHEAD_DELAY,
+		               (GSourceFunc) gpk_application_search_typeahead_cb,
+		               priv);
+	g_source_set_name_by_id (priv->search_typeahead_id, "[GpkApplication] typeahead");
+
 	return FALSE;
 }
 
@@ -1038,6 +1401,9 @@ gpk_application_install_packages_cb (PkTask *task, GAsyncResult *res, GpkApplica
 out:
 	gpk_application_stop_progress_acction (priv);
 
+	/* the state of the packages changed */
+	gpk_backend_invalidate_packages (priv->backend);
+
 	/* idle add in the background */
 	idle_id = g_idle_add ((GSourceFunc) gpk_application_perform_search_idle_cb, priv);
 	g_source_set_name_by_id (idle_id, "[GpkApplication] search");
@@ -1086,6 +1452,9 @@ gpk_application_remove_packages_cb (PkTask *task, GAsyncResult *res, GpkApplicat
 out:
 	gpk_application_stop_progress_acction (priv);
 
+	/* the state of the packages changed */
+	gpk_backend_invalidate_packages (priv->backend);
+
 	/* idle add in the background */
 	idle_id = g_idle_add ((GSourceFunc) gpk_application_perform_search_idle_cb, priv);
 	g_source_set_name_by_id (idle_id, "[GpkApplication] search");
@@ -1109,15 +1478,25 @@ gpk_application_packages_add_columns (GpkApplicationPrivate *priv)
 	column = gtk_tree_view_column_new ();
 	renderer = gtk_cell_renderer_pixbuf_new ();
 	gtk_tree_view_column_pack_start (column, renderer, FALSE);
-	gtk_tree_view_column_add_attribute (column, renderer, "pixbuf", PACKAGES_COLUMN_PIXBUF);
+	gtk_tree_view_column_set_cell_data_func (column, renderer,
+	                                         (GtkTreeCellDataFunc) gpk_application_packages_pixbuf_data_func,
+	                                         priv, NULL);
+	gtk_tree_view_column_set_sizing (column, GTK_TREE_VIEW_COLUMN_FIXED);
+	gtk_tree_view_column_set_fixed_width (column, 48);
 	gtk_tree_view_append_column (treeview, column);
 
 	/* column for name */
 	renderer = gtk_cell_renderer_text_new ();
 	/* TRANSLATORS: column for package name */
-	column = gtk_tree_view_column_new_with_attributes (_("Name"), renderer,
-							   "markup", PACKAGES_COLUMN_TEXT, NULL);
-	gtk_tree_view_column_set_sort_column_id (column, PACKAGES_COLUMN_TEXT);
+	column = gtk_tree_view_column_new ();
+	gtk_tree_view_column_set_title (column, _("Name"));
+	gtk_tree_view_column_pack_start (column, renderer, TRUE);
+	gtk_tree_view_column_set_cell_data_func (column, renderer,
+	                                         (GtkTreeCellDataFunc) gpk_application_packages_text_data_func,
+	                                         priv, NULL);
+	gtk_tree_view_column_set_sort_column_id (column, PACKAGES_COLUMN_ID);
+	gtk_tree_view_column_set_sizing (column, GTK_TREE_VIEW_COLUMN_FIXED);
+	gtk_tree_view_column_set_expand (column, TRUE);
 	gtk_tree_view_append_column (treeview, column);
 }
 
@@ -1132,6 +1511,32 @@ package_is_installed (const gchar *data)
 	return FALSE;
 }
 
+/**
+ * gpk_application_details_icon_loaded_cb:
+ **/
+static void
+gpk_application_details_icon_loaded_cb (GpkIconLoader         *loader,
+                                        GAsyncResult          *res,
+                                        GpkApplicationPrivate *priv)
+{
+	GtkWidget *widget;
+	GdkPixbuf *pixbuf = NULL;
+	GError *error = NULL;
+
+	pixbuf = gpk_icon_loader_load_finish (loader, res, &error);
+	if (pixbuf == NULL) {
+		if (!g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED))
+			g_debug ("failed to load icon: %s", error->message);
+		g_error_free (error);
+		return;
+	}
+
+	widget = GTK_WIDGET (gtk_builder_get_object (priv->builder, "icon_details_package"));
+	gtk_image_set_from_pixbuf (GTK_IMAGE (widget), pixbuf);
+
+	g_object_unref (pixbuf);
+}
+
 /**
  * gpk_application_get_details_cb:
  **/
@@ -1155,6 +1560,7 @@ gpk_application_get_details_cb (PkClient *client, GAsyncResult *res, GpkApplicat
 	gchar *desktop_id = NULL;
 	gchar *url = NULL;
 	GdkPixbuf *app_pixbuf = NULL;
+	const gchar *icon_filename = NULL;
 	gchar *license = NULL;
 	gchar *summary = NULL, *package_details = NULL, *package_pretty = NULL, *description = NULL, *escape_url = NULL;
 	gchar *donation = NULL, *translate = NULL, *report = NULL;
@@ -1201,7 +1607,9 @@ gpk_application_get_details_cb (PkClient *client, GAsyncResult *res, GpkApplicat
 	if (component != NULL) {
 		summary = g_strdup(as_component_get_name (component));
 		package_details = g_strdup(as_component_get_summary (component));
-		app_pixbuf = gpk_get_pixbuf_from_component (component, 48);
+		icon_filename = gpk_get_icon_filename_from_component (component, 48);
+		if (icon_filename != NULL)
+			app_pixbuf = gpk_icon_loader_lookup (priv->icon_loader, icon_filename, 48);
 		desktop_id = gpk_as_component_get_desktop_id (component);
 		description = g_strdup(as_component_get_description (component));
 		license = g_strdup(as_component_get_project_license(component));
@@ -1251,6 +1659,20 @@ gpk_application_get_details_cb (PkClient *client, GAsyncResult *res, GpkApplicat
 		                              GTK_ICON_SIZE_DIALOG);
 	}
 
+	/* the icon of the previous package is no longer interesting */
+	g_cancellable_cancel (priv->details_icon_cancellable);
+	g_object_unref (priv->details_icon_cancellable);
+	priv->details_icon_cancellable = g_cancellable_new ();
+
+	if (app_pixbuf == NULL && icon_filename != NULL) {
+		gpk_icon_loader_load_async (priv->icon_loader,
+		                            as_component_get_id (component),
+		                            icon_filename, 48,
+		                            priv->details_icon_cancellable,
+		                            (GAsyncReadyCallback) gpk_application_details_icon_loaded_cb,
+		                            priv);
+	}
+
 	g_free (priv->desktop_id);
 	priv->desktop_id = g_strdup(desktop_id);
 
@@ -1704,6 +2126,9 @@ gpk_application_refresh_cache_cb (PkClient *client, GAsyncResult *res, GpkApplic
 out:
 	gpk_application_stop_progress_acction (priv);
 
+	/* the new metadata can bring new versions */
+	gpk_backend_invalidate_packages (priv->backend);
+
 	if (error_code != NULL)
 		g_object_unref (error_code);
 	if (results != NULL)
@@ -1740,7 +2165,6 @@ gpk_application_show_category (GpkApplicationPrivate *priv,
 {
 	GtkWidget *widget = NULL;
 	GpkCategory *category = NULL;
-	gchar **categories = NULL, **packages = NULL;
 	gchar *category_name = NULL;
 
 	gpk_application_clear_packages (priv);
@@ -1754,15 +2178,7 @@ gpk_application_show_category (GpkApplicationPrivate *priv,
 	g_free (priv->search_text);
 	priv->search_text = g_strdup (category_id);
 
-	packages = gpk_category_get_packages (category);
-	if (packages) {
-		gpk_application_search_packages (priv, packages);
-		g_strfreev (packages);
-	} else {
-		categories = gpk_category_get_categories (category);
-		gpk_application_search_categories (priv, categories);
-		g_strfreev (categories);
-	}
+	gpk_application_search_category (priv, category_id);
 
 	g_free (category_name);
 }
@@ -1776,7 +2192,7 @@ gpk_application_show_categories (GpkApplicationPrivate *priv)
 	GtkWidget *widget = NULL;
 	GPtrArray *categories = NULL;
 	GpkCategory *category = NULL;
-	GtkTreeIter iter;
+	GBytes *sort_key = NULL;
 	gchar *id = NULL, *name = NULL, *comment = NULL, *icon = NULL;
 	gchar *text = NULL;
 	gboolean is_special = FALSE, has_special = FALSE;
@@ -1786,6 +2202,10 @@ gpk_application_show_categories (GpkApplicationPrivate *priv)
 
 	gpk_application_clear_packages (priv);
 
+	/* the separator is not as high as the categories */
+	widget = GTK_WIDGET (gtk_builder_get_object (priv->builder, "treeview_packages"));
+	gtk_tree_view_set_fixed_height_mode (GTK_TREE_VIEW (widget), FALSE);
+
 	widget = GTK_WIDGET (gtk_builder_get_object (priv->builder, "label_category"));
 	gtk_label_set_label (GTK_LABEL (widget), _("Categories"));
 
@@ -1807,16 +2227,18 @@ gpk_application_show_categories (GpkApplicationPrivate *priv)
 		if (is_special)
 			has_special = TRUE;
 
-		gtk_list_store_append (priv->packages_store, &iter);
-		gtk_list_store_set (priv->packages_store, &iter,
-		                    PACKAGES_COLUMN_TEXT, text,
-		                    PACKAGES_COLUMN_PIXBUF, gpk_get_pixbuf_from_icon_name (icon, 32),
-		                    PACKAGES_COLUMN_ID, id,
-		                    PACKAGES_COLUMN_APP_NAME, name,
-		                    PACKAGES_COLUMN_IS_SPECIAL, is_special,
-		                    PACKAGES_COLUMN_IS_CATEGORY, TRUE,
-		                    -1);
-
+		sort_key = gpk_packages_list_sort_key_new (is_special, FALSE, TRUE, name, id);
+		gtk_list_store_insert_with_values (priv->packages_store, NULL, -1,
+		                                   PACKAGES_COLUMN_TEXT, text,
+		                                   PACKAGES_COLUMN_PIXBUF, gpk_get_pixbuf_from_icon_name (icon, 32),
+		                                   PACKAGES_COLUMN_ID, id,
+		                                   PACKAGES_COLUMN_APP_NAME, name,
+		                                   PACKAGES_COLUMN_IS_SPECIAL, is_special,
+		                                   PACKAGES_COLUMN_IS_CATEGORY, TRUE,
+		                                   PACKAGES_COLUMN_SORT_KEY, sort_key,
+		                                   -1);
+
+		g_bytes_unref (sort_key);
 		g_free (id);
 		g_free (name);
 		g_free (comment);
@@ -1825,10 +2247,13 @@ gpk_application_show_categories (GpkApplicationPrivate *priv)
 	}
 
 	if (has_special) {
-		gtk_list_store_append (priv->packages_store, &iter);
-		gtk_list_store_set (priv->packages_store, &iter,
-		                    PACKAGES_COLUMN_IS_SEPARATOR, TRUE,
-		                    PACKAGES_COLUMN_ID, "separator", -1);
+		sort_key = gpk_packages_list_sort_key_new (FALSE, TRUE, FALSE, NULL, NULL);
+		gtk_list_store_insert_with_values (priv->packages_store, NULL, -1,
+		                                   PACKAGES_COLUMN_IS_SEPARATOR, TRUE,
+		                                   PACKAGES_COLUMN_ID, "separator",
+		                                   PACKAGES_COLUMN_SORT_KEY, sort_key,
+		                                   -1);
+		g_bytes_unref (sort_key);
 	}
 
 	g_ptr_array_unref (categories);
@@ -1847,6 +2272,100 @@ gpk_application_key_changed_cb (GSettings *settings, const gchar *key, GpkApplic
 	// TODO:
 }
 
+/**
+ * gpk_application_background_refresh_progress_cb:
+ **/
+static void
+gpk_application_background_refresh_progress_cb (PkProgress            *progress,
+                                                 PkProgressType         type,
+                                                 GpkApplicationPrivate *priv)
+{
+	GtkWidget *widget;
+	PkStatusEnum status;
+	gint percentage;
+	gchar *text = NULL;
+
+	if (type != PK_PROGRESS_TYPE_STATUS &&
+	    type != PK_PROGRESS_TYPE_PERCENTAGE)
+		return;
+
+	g_object_get (progress,
+		      "status", &status,
+		      "percentage", &percentage,
+		      NULL);
+
+	if (status == PK_STATUS_ENUM_FINISHED)
+		return;
+
+	if (percentage > 0 && percentage <= 100) {
+		text = g_strdup_printf ("%s (%i%%)", gpk_status_enum_to_localised_text (status), percentage);
+	} else {
+		text = g_strdup (gpk_status_enum_to_localised_text (status));
+	}
+
+	widget = GTK_WIDGET (gtk_builder_get_object (priv->builder, "main-header"));
+	gtk_header_bar_set_subtitle (GTK_HEADER_BAR (widget), text);
+
+	g_free (text);
+}
+
+/**
+ * gpk_application_background_refresh_ready:
+ **/
+static void
+gpk_application_background_refresh_ready (GpkBackend            *backend,
+                                          GAsyncResult          *res,
+                                          GpkApplicationPrivate *priv)
+{
+	GtkWidget *widget;
+	GError *error = NULL;
+
+	widget = GTK_WIDGET (gtk_builder_get_object (priv->builder, "main-header"));
+	gtk_header_bar_set_subtitle (GTK_HEADER_BAR (widget), NULL);
+
+	/* just keep working with the old cache */
+	if (!gpk_backend_refresh_finish (backend, res, &error)) {
+		if (!g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED))
+			g_warning ("failed to refresh the cache in background: %s", error->message);
+		g_error_free (error);
+		return;
+	}
+
+	/* update the shown packages, unless the user is waiting for other search */
+	if (!priv->search_in_progress)
+		gpk_application_restore_search (priv);
+}
+
+/**
+ * gpk_application_backend_stage_finished_cb:
+ **/
+static void
+gpk_application_backend_stage_finished_cb (GpkBackend            *backend,
+                                           GpkBackendStage        stage,
+                                           GpkApplicationPrivate *priv)
+{
+	GtkWidget *widget = NULL;
+	gchar *category_id = NULL;
+
+	/* show the category that was selected while indexing */
+	if (stage == GPK_BACKEND_STAGE_CATEGORY_INDEX &&
+	    priv->search_category_waiting != NULL) {
+		category_id = g_steal_pointer (&priv->search_category_waiting);
+		gpk_application_search_category (priv, category_id);
+		g_free (category_id);
+		return;
+	}
+
+	if (stage != GPK_BACKEND_STAGE_CATEGORIES)
+		return;
+
+	/* show the categories while the rest of the backend is still loading */
+	gpk_application_show_categories (priv);
+
+	widget = GTK_WIDGET (gtk_builder_get_object (priv->builder, "scrolledwindow_packages"));
+	gtk_widget_show (widget);
+}
+
 /**
  * gpk_application_open_backend_ready:
  **/
@@ -1875,6 +2394,14 @@ gpk_application_open_backend_ready (GpkBackend            *backend,
 
 	gpk_application_stop_progress_acction (priv);
 
+	/* the cache was not refreshed while opening */
+	if (!gpk_backend_stage_is_finished (backend, GPK_BACKEND_STAGE_REFRESH)) {
+		gpk_backend_refresh (backend,
+		                     priv->refresh_cancellable,
+		                     (PkProgressCallback) gpk_application_background_refresh_progress_cb, priv,
+		                     (GAsyncReadyCallback) gpk_application_background_refresh_ready, priv);
+	}
+
 	/* explicit show categories.. */
 	widget = GTK_WIDGET (gtk_builder_get_object (priv->builder, "scrolledwindow_packages"));
 	gtk_widget_show (widget);
@@ -1913,8 +2440,14 @@ gpk_application_startup_cb (GtkApplication *application, GpkApplicationPrivate *
 
 	priv->settings = g_settings_new (GPK_SETTINGS_SCHEMA);
 	priv->cancellable = g_cancellable_new ();
+	priv->refresh_cancellable = g_cancellable_new ();
+	priv->search_cancellable = g_cancellable_new ();
 
 	priv->backend = gpk_backend_new ();
+	gpk_backend_set_background_refresh (priv->backend,
+	                                    g_settings_get_boolean (priv->settings, GPK_SETTINGS_BACKGROUND_REFRESH));
+	g_signal_connect (priv->backend, "stage-finished",
+	                  G_CALLBACK (gpk_application_backend_stage_finished_cb), priv);
 
 	/* watch gnome-packagekit keys */
 	g_signal_connect (priv->settings, "changed", G_CALLBACK (gpk_application_key_changed_cb), priv);
@@ -1923,6 +2456,11 @@ gpk_application_startup_cb (GtkApplication *application, GpkApplicationPrivate *
 
 	priv->packages_store = gpk_packages_list_store_new ();
 
+	priv->icon_loader = gpk_icon_loader_new ();
+	priv->icons_cancellable = g_cancellable_new ();
+	priv->icons_pending = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+	priv->details_icon_cancellable = g_cancellable_new ();
+
 	/* add application specific icons to search path */
 	gtk_icon_theme_append_search_path (gtk_icon_theme_get_default (),
 					   PKGDATADIR G_DIR_SEPARATOR_S "icons");
@@ -2003,9 +2541,6 @@ gpk_application_startup_cb (GtkApplication *application, GpkApplicationPrivate *
 	g_signal_connect (GTK_EDITABLE (widget), "changed",
 			  G_CALLBACK (gpk_application_text_changed_cb), priv);
 
-	/* mark find button insensitive */
-	gpk_application_set_button_find_sensitivity (priv);
-
 	widget = GTK_WIDGET (gtk_builder_get_object (priv->builder, "treeview_packages"));
 	gtk_tree_view_columns_autosize (GTK_TREE_VIEW (widget));
 
@@ -2146,16 +2681,31 @@ main (int argc, char *argv[])
 		g_object_unref (priv->backend);
 	if (priv->packages_store != NULL)
 		g_object_unref (priv->packages_store);
+	if (priv->icon_loader != NULL)
+		g_object_unref (priv->icon_loader);
+	if (priv->icons_cancellable != NULL)
+		g_object_unref (priv->icons_cancellable);
+	if (priv->icons_pending != NULL)
+		g_hash_table_unref (priv->icons_pending);
+	if (priv->details_icon_cancellable != NULL)
+		g_object_unref (priv->details_icon_cancellable);
 	if (priv->settings != NULL)
 		g_object_unref (priv->settings);
 	if (priv->builder != NULL)
 		g_object_unref (priv->builder);
 	if (priv->cancellable != NULL)
 		g_object_unref (priv->cancellable);
+	if (priv->refresh_cancellable != NULL)
+		g_object_unref (priv->refresh_cancellable);
+	if (priv->search_cancellable != NULL)
+		g_object_unref (priv->search_cancellable);
+	if (priv->search_typeahead_id > 0)
+		g_source_remove (priv->search_typeahead_id);
 	if (priv->status_id > 0)
 		g_source_remove (priv->status_id);
 
 	g_free (priv->search_text);
+	g_free (priv->search_category_waiting);
 	g_free (priv->selection_id);
 	g_free (priv->desktop_id);
 
@@ -21,11 +21,31 @@
 
 #include "config.h"
 
+#include <errno.h>
 #include <string.h>
 #include <glib.h>
+#include <glib/gstdio.h>
 
 #include "gpk-as-store.h"
 
+#define GPK_AS_STORE_CACHE_VERSION	1
+#define GPK_AS_STORE_CACHE_TYPE		"(usa(ssssasasa(uuuss)))"
+#define GPK_AS_STORE_CACHE_RECORD	"(ssssasasa(uuuss))"
+
+static const gchar *gpk_as_store_metadata_dirs[] = {
+	"/usr/share/swcatalog/xml",
+	"/usr/share/swcatalog/yaml",
+	"/usr/share/app-info/xmls",
+	"/usr/share/app-info/yaml",
+	"/var/cache/app-info/xmls",
+	"/var/cache/app-info/yaml",
+	"/var/lib/app-info/xmls",
+	"/var/lib/app-info/yaml",
+	"/usr/share/metainfo",
+	"/usr/share/appdata",
+	NULL
+};
+
 static void     gpk_as_store_finalize	(GObject	  *object);
 
 struct _GpkAsStore
@@ -33,45 +53,585 @@ struct _GpkAsStore
 	GObject			 parent;
 
 	AsPool			*as_pool;
+	GMutex			 pool_lock;
+	gint			 pool_loaded;
 	GHashTable		*packages_components;
+
+	gchar			*cache_stamp;
+	GVariant		*cache_records;
+	GMutex			 cache_lock;
+	GHashTable		*cache_index;
+	GHashTable		*cache_components;
 };
 
 G_DEFINE_TYPE (GpkAsStore, gpk_as_store, G_TYPE_OBJECT)
 
-gboolean
-gpk_as_store_load (GpkAsStore *store, GCancellable *cancellable, GError **error)
+static gchar *
+gpk_as_store_get_cache_filename (void)
+{
+	return g_build_filename (g_get_user_cache_dir (),
+	                         "xings-software",
+	                         "appstream-index.gvariant",
+	                         NULL);
+}
+
+/**
+ * gpk_as_store_get_metadata_stamp:
+ *
+ * Resume the metadata that AsPool would load, so any change on it,
+ * or the user language, invalidates the index cache.
+ **/
+static gchar *
+gpk_as_store_get_metadata_stamp (void)
 {
+	GString *stamp = NULL;
+	GDir *dir = NULL;
+	GStatBuf st;
+	const gchar *name = NULL;
+	gchar *file = NULL;
+	gint64 mtime = 0;
+	guint count = 0;
+	guint i = 0;
+
+	stamp = g_string_new (g_get_language_names ()[0]);
+
+	for (i = 0; gpk_as_store_metadata_dirs[i] != NULL; i++) {
+		if (g_stat (gpk_as_store_metadata_dirs[i], &st) != 0)
+			continue;
+
+		mtime = (gint64) st.st_mtime;
+		count = 0;
+
+		/* files can be replaced in place, so check them too */
+		dir = g_dir_open (gpk_as_store_metadata_dirs[i], 0, NULL);
+		if (dir != NULL) {
+			while ((name = g_dir_read_name (dir)) != NULL) {
+				file = g_build_filename (gpk_as_store_metadata_dirs[i], name, NULL);
+				if (g_stat (file, &st) == 0)
+					mtime = MAX (mtime, (gint64) st.st_mtime);
+				g_free (file);
+				count++;
+			}
+			g_dir_close (dir);
+		}
+
+		g_string_append_printf (stamp, ";%s:%" G_GINT64_FORMAT ":%u",
+		                        gpk_as_store_metadata_dirs[i], mtime, count);
+	}
+
+	return g_string_free (stamp, FALSE);
+}
+
+static GVariant *
+gpk_as_store_component_to_cache (AsComponent *component)
+{
+	GVariantBuilder pkgnames_builder, categories_builder, icons_builder;
+	GPtrArray *categories = NULL, *icons = NULL;
+	AsIcon *icon = NULL;
 	gchar **pkgnames = NULL;
-	GPtrArray *components = NULL;
+	gchar *desktop_id = NULL;
+	GVariant *record = NULL;
+	guint i = 0;
+
+	g_variant_builder_init (&pkgnames_builder, G_VARIANT_TYPE_STRING_ARRAY);
+	pkgnames = as_component_get_pkgnames (component);
+	for (i = 0; pkgnames[i] != NULL; i++)
+		g_variant_builder_add (&pkgnames_builder, "s", pkgnames[i]);
+
+	g_variant_builder_init (&categories_builder, G_VARIANT_TYPE_STRING_ARRAY);
+	categories = as_component_get_categories (component);
+	for (i = 0; i < categories->len; i++)
+		g_variant_builder_add (&categories_builder, "s", g_ptr_array_index (categories, i));
+
+	g_variant_builder_init (&icons_builder, G_VARIANT_TYPE ("a(uuuss)"));
+	icons = as_component_get_icons (component);
+	for (i = 0; i < icons->len; i++) {
+		icon = AS_ICON (g_ptr_array_index (icons, i));
+		g_variant_builder_add (&icons_builder, "(uuuss)",
+		                       as_icon_get_kind (icon),
+		                       as_icon_get_width (icon),
+		                       as_icon_get_height (icon),
+		                       as_icon_get_name (icon) != NULL ? as_icon_get_name (icon) : "",
+		                       as_icon_get_filename (icon) != NULL ? as_icon_get_filename (icon) : "");
+	}
+
+	desktop_id = gpk_as_component_get_desktop_id (component);
+
+	record = g_variant_new (GPK_AS_STORE_CACHE_RECORD,
+	                        as_component_get_id (component) != NULL ? as_component_get_id (component) : "",
+	                        as_component_get_name (component) != NULL ? as_component_get_name (component) : "",
+	                        as_component_get_summary (component) != NULL ? as_component_get_summary (component) : "",
+	                        desktop_id != NULL ? desktop_id : "",
+	                        &pkgnames_builder,
+	                        &categories_builder,
+	                        &icons_builder);
+
+	g_free (desktop_id);
+
+	return record;
+}
+
+static AsComponent *
+gpk_as_store_component_from_cache (GVariant *record)
+{
 	AsComponent *component = NULL;
-	const gchar *pkgname = NULL;
-	guint i = 0, p = 0;
+	AsLaunchable *launchable = NULL;
+	AsIcon *icon = NULL;
+	GVariantIter *pkgnames_iter = NULL, *categories_iter = NULL, *icons_iter = NULL;
+	GPtrArray *pkgnames = NULL;
+	const gchar *id = NULL, *name = NULL, *summary = NULL, *desktop_id = NULL;
+	const gchar *value = NULL, *icon_name = NULL, *icon_filename = NULL;
+	guint kind = 0, width = 0, height = 0;
+
+	g_variant_get (record, "(&s&s&s&sasasa(uuuss))",
+	               &id, &name, &summary, &desktop_id,
+	               &pkgnames_iter, &categories_iter, &icons_iter);
+
+	component = as_component_new ();
+	as_component_set_id (component, id);
+	if (name[0] != '\0')
+		as_component_set_name (component, name, NULL);
+	if (summary[0] != '\0')
+		as_component_set_summary (component, summary, NULL);
+
+	pkgnames = g_ptr_array_new ();
+	while (g_variant_iter_next (pkgnames_iter, "&s", &value))
+		g_ptr_array_add (pkgnames, (gpointer) value);
+	g_ptr_array_add (pkgnames, NULL);
+	as_component_set_pkgnames (component, (gchar **) pkgnames->pdata);
+	g_ptr_array_unref (pkgnames);
+
+	while (g_variant_iter_next (categories_iter, "&s", &value))
+		as_component_add_category (component, value);
+
+	while (g_variant_iter_next (icons_iter, "(uuu&s&s)", &kind, &width, &height, &icon_name, &icon_filename)) {
+		icon = as_icon_new ();
+		as_icon_set_kind (icon, (AsIconKind) kind);
+		as_icon_set_width (icon, width);
+		as_icon_set_height (icon, height);
+		if (icon_name[0] != '\0')
+			as_icon_set_name (icon, icon_name);
+		if (icon_filename[0] != '\0')
+			as_icon_set_filename (icon, icon_filename);
+		as_component_add_icon (component, icon);
+		g_object_unref (icon);
+	}
 
-	if (!as_pool_load (store->as_pool, cancellable, error))
-		return FALSE;
+	if (desktop_id[0] != '\0') {
+		launchable = as_launchable_new ();
+		as_launchable_set_kind (launchable, AS_LAUNCHABLE_KIND_DESKTOP_ID);
+		as_launchable_add_entry (launchable, desktop_id);
+		as_component_add_launchable (component, launchable);
+		g_object_unref (launchable);
+	}
+
+	g_variant_iter_free (pkgnames_iter);
+	g_variant_iter_free (categories_iter);
+	g_variant_iter_free (icons_iter);
+
+	return component;
+}
+
+/**
+ * gpk_as_store_save_cache:
+ *
+ * Serialize all components with packages to the index cache.
+ **/
+static gboolean
+gpk_as_store_save_cache (const gchar *stamp, GPtrArray *components, GError **error)
+{
+	GVariantBuilder builder;
+	GVariant *cache = NULL;
+	AsComponent *component = NULL;
+	gchar *filename = NULL, *dirname = NULL;
+	gboolean ret = FALSE;
+	guint i = 0;
+
+	g_variant_builder_init (&builder, G_VARIANT_TYPE ("a" GPK_AS_STORE_CACHE_RECORD));
+	for (i = 0; i < components->len; i++) {
+		component = AS_COMPONENT (g_ptr_array_index (components, i));
+		if (as_component_get_pkgnames (component) == NULL)
+			continue;
+		g_variant_builder_add_value (&builder, gpk_as_store_component_to_cache (component));
+	}
+
+	cache = g_variant_ref_sink (g_variant_new ("(usa" GPK_AS_STORE_CACHE_RECORD ")",
+	                                           GPK_AS_STORE_CACHE_VERSION,
+	                                           stamp,
+	                                           &builder));
+
+	filename = gpk_as_store_get_cache_filename ();
+	dirname = g_path_get_dirname (filename);
+	if (g_mkdir_with_parents (dirname, 0700) != 0) {
+		g_set_error (error, G_FILE_ERROR,
+		             g_file_error_from_errno (errno),
+		             "Failed to create %s", dirname);
+		goto out;
+	}
+
+	ret = g_file_set_contents (filename,
+	                           g_variant_get_data (cache),
+	                           (gssize) g_variant_get_size (cache),
+	                           error);
+
+out:
+	g_variant_unref (cache);
+	g_free (dirname);
+	g_free (filename);
+
+	return ret;
+}
+
+/**
+ * gpk_as_store_load_cache:
+ *
+ * Map the index cache, and only index the package names, so that the
+ * components are only created when they are really requested.
+ **/
+static gboolean
+gpk_as_store_load_cache (GpkAsStore *store)
+{
+	GMappedFile *mapped = NULL;
+	GBytes *bytes = NULL;
+	GVariant *cache = NULL, *record = NULL, *pkgnames = NULL;
+	GError *error = NULL;
+	const gchar *stamp = NULL, *pkgname = NULL;
+	gchar *filename = NULL;
+	gboolean ret = FALSE;
+	guint32 version = 0;
+	gsize i = 0, j = 0;
+
+	filename = gpk_as_store_get_cache_filename ();
+	mapped = g_mapped_file_new (filename, FALSE, &error);
+	if (mapped == NULL) {
+		g_debug ("No appstream index cache: %s", error->message);
+		g_error_free (error);
+		goto out;
+	}
+
+	bytes = g_mapped_file_get_bytes (mapped);
+	cache = g_variant_ref_sink (g_variant_new_from_bytes (G_VARIANT_TYPE (GPK_AS_STORE_CACHE_TYPE), bytes, FALSE));
+
+	g_variant_get_child (cache, 0, "u", &version);
+	g_variant_get_child (cache, 1, "&s", &stamp);
+	if (version != GPK_AS_STORE_CACHE_VERSION ||
+	    g_strcmp0 (stamp, store->cache_stamp) != 0) {
+		g_debug ("Appstream index cache is outdated");
+		goto out;
+	}
+
+	store->cache_records = g_variant_get_child_value (cache, 2);
+	for (i = 0; i < g_variant_n_children (store->cache_records); i++) {
+		record = g_variant_get_child_value (store->cache_records, i);
+		pkgnames = g_variant_get_child_value (record, 4);
+		for (j = 0; j < g_variant_n_children (pkgnames); j++) {
+			g_variant_get_child (pkgnames, j, "&s", &pkgname);
+			g_hash_table_insert (store->cache_index,
+			                     g_strdup (pkgname),
+			                     GSIZE_TO_POINTER (i));
+		}
+		g_variant_unref (pkgnames);
+		g_variant_unref (record);
+	}
+
+	g_debug ("Appstream cached components: %" G_GSIZE_FORMAT, g_variant_n_children (store->cache_records));
+	g_debug ("Appstream cached packages: %u", g_hash_table_size (store->cache_index));
+
+	ret = TRUE;
+
+out:
+	if (cache != NULL)
+		g_variant_unref (cache);
+	if (bytes != NULL)
+		g_bytes_unref (bytes);
+	if (mapped != NULL)
+		g_mapped_file_unref (mapped);
+	g_free (filename);
+
+	return ret;
+}
+
+static AsComponent *
+gpk_as_store_get_cached_component (GpkAsStore *store, const gchar *pkgname)
+{
+	AsComponent *component = NULL;
+	GVariant *record = NULL;
+	gpointer index = NULL;
+
+	g_mutex_lock (&store->cache_lock);
+
+	component = g_hash_table_lookup (store->cache_components, pkgname);
+	if (component != NULL)
+		goto out;
+
+	if (!g_hash_table_lookup_extended (store->cache_index, pkgname, NULL, &index))
+		goto out;
+
+	record = g_variant_get_child_value (store->cache_records, GPOINTER_TO_SIZE (index));
+	component = gpk_as_store_component_from_cache (record);
+	g_variant_unref (record);
+
+	g_hash_table_insert (store->cache_components,
+	                     g_strdup (pkgname),
+	                     component);
+
+out:
+	g_mutex_unlock (&store->cache_lock);
+
+	return component;
+}
+
+static void
+gpk_as_store_index_components (GHashTable *packages_components, GPtrArray *components)
+{
+	gchar **pkgnames = NULL;
+	AsComponent *component = NULL;
+	guint i = 0, p = 0;
 
-	components = as_pool_get_components (store->as_pool);
 	for (i = 0; i < components->len; i++) {
 		component = AS_COMPONENT (g_ptr_array_index (components, i));
 		pkgnames = as_component_get_pkgnames (component);
 		if (pkgnames == NULL)
 			continue;
 		for (p = 0; pkgnames[p] != NULL; p++) {
-			pkgname = pkgnames[p];
-			g_hash_table_insert (store->packages_components,
-			                     g_strdup(pkgname),
+			g_hash_table_insert (packages_components,
+			                     g_strdup(pkgnames[p]),
 			                     g_object_ref (component));
 		}
 	}
 
 	g_debug ("Appstream components: %u", components->len);
-	g_debug ("Appstream packages: %u", g_hash_table_size(store->packages_components));
+	g_debug ("Appstream packages: %u", g_hash_table_size (packages_components));
+}
+
+/**
+ * gpk_as_store_load_pool:
+ *
+ * Must be called with the pool_lock held.
+ **/
+static gboolean
+gpk_as_store_load_pool (GpkAsStore *store, GCancellable *cancellable, GError **error)
+{
+	GPtrArray *components = NULL;
+	GError *cache_error = NULL;
+
+	/* the pool can be requested before gpk_as_store_load() */
+	if (store->cache_stamp == NULL)
+		store->cache_stamp = gpk_as_store_get_metadata_stamp ();
+
+	if (!as_pool_load (store->as_pool, cancellable, error))
+		return FALSE;
+
+	components = as_pool_get_components (store->as_pool);
+	gpk_as_store_index_components (store->packages_components, components);
+
+	/* only rewrite the index when it was invalid */
+	if (store->cache_records == NULL) {
+		if (!gpk_as_store_save_cache (store->cache_stamp, components, &cache_error)) {
+			g_warning ("Failed to save appstream index cache: %s", cache_error->message);
+			g_error_free (cache_error);
+		}
+	}
 
 	g_ptr_array_unref (components);
 
+	g_atomic_int_set (&store->pool_loaded, TRUE);
+
 	return TRUE;
 }
 
+static gboolean
+gpk_as_store_ensure_pool (GpkAsStore *store, GCancellable *cancellable, GError **error)
+{
+	gboolean ret = TRUE;
+
+	g_mutex_lock (&store->pool_lock);
+	if (!g_atomic_int_get (&store->pool_loaded))
+		ret = gpk_as_store_load_pool (store, cancellable, error);
+	g_mutex_unlock (&store->pool_lock);
+
+	return ret;
+}
+
+static void
+gpk_as_store_load_pool_threaded (GTask        *task,
+                                 gpointer      source_object,
+                                 gpointer      task_data,
+                                 GCancellable *cancellable)
+{
+	GpkAsStore *store = GPK_AS_STORE (source_object);
+	GError *error = NULL;
+
+	if (!gpk_as_store_ensure_pool (store, cancellable, &error)) {
+		g_warning ("Failed to load appstream pool: %s", error->message);
+		g_task_return_error (task, error);
+		return;
+	}
+
+	g_task_return_boolean (task, TRUE);
+}
+
+gboolean
+gpk_as_store_load (GpkAsStore *store, GCancellable *cancellable, GError **error)
+{
+	GTask *task = NULL;
+
+	if (g_atomic_int_get (&store->pool_loaded))
+		return TRUE;
+
+	g_free (store->cache_stamp);
+	store->cache_stamp = gpk_as_store_get_metadata_stamp ();
+
+	/* cold start, load the pool and write the cache */
+	if (!gpk_as_store_load_cache (store))
+		return gpk_as_store_ensure_pool (store, cancellable, error);
+
+	/* warm start, serve the components from the cache while loading the full pool */
+	task = g_task_new (store, NULL, NULL, NULL);
+	g_task_set_source_tag (task, gpk_as_store_load);
+	g_task_run_in_thread (task, gpk_as_store_load_pool_threaded);
+	g_object_unref (task);
+
+	return TRUE;
+}
+
+typedef struct {
+	AsPool		*as_pool;
+	GHashTable	*packages_components;
+	gchar		*cache_stamp;
+} GpkAsStoreReload;
+
+static void
+gpk_as_store_reload_free (GpkAsStoreReload *reload)
+{
+	g_clear_object (&reload->as_pool);
+	if (reload->packages_components != NULL)
+		g_hash_table_unref (reload->packages_components);
+	g_free (reload->cache_stamp);
+	g_free (reload);
+}
+
+static void
+gpk_as_store_reload_threaded (GTask        *task,
+                              gpointer      source_object,
+                              gpointer      task_data,
+                              GCancellable *cancellable)
+{
+	GpkAsStore *store = GPK_AS_STORE (source_object);
+	GpkAsStoreReload *reload = NULL;
+	GPtrArray *components = NULL;
+	GError *error = NULL, *cache_error = NULL;
+	gchar *stamp = NULL;
+
+	/* the pool could be still loading since the start */
+	if (!gpk_as_store_ensure_pool (store, cancellable, &error)) {
+		g_task_return_error (task, error);
+		return;
+	}
+
+	stamp = gpk_as_store_get_metadata_stamp ();
+	if (g_strcmp0 (stamp, store->cache_stamp) == 0) {
+		g_debug ("Appstream metadata did not change");
+		g_free (stamp);
+		g_task_return_pointer (task, NULL, NULL);
+		return;
+	}
+
+	/* load aside, the current pool is in use by the main thread */
+	reload = g_new0 (GpkAsStoreReload, 1);
+	reload->cache_stamp = stamp;
+	reload->as_pool = as_pool_new ();
+	if (!as_pool_load (reload->as_pool, cancellable, &error)) {
+		gpk_as_store_reload_free (reload);
+		g_task_return_error (task, error);
+		return;
+	}
+
+	reload->packages_components = g_hash_table_new_full (g_str_hash, g_str_equal, (GDestroyNotify) g_free, (GDestroyNotify) g_object_unref);
+	components = as_pool_get_components (reload->as_pool);
+	gpk_as_store_index_components (reload->packages_components, components);
+
+	if (!gpk_as_store_save_cache (reload->cache_stamp, components, &cache_error)) {
+		g_warning ("Failed to save appstream index cache: %s", cache_error->message);
+		g_error_free (cache_error);
+	}
+	g_ptr_array_unref (components);
+
+	g_task_return_pointer (task, reload, (GDestroyNotify) gpk_as_store_reload_free);
+}
+
+static void
+gpk_as_store_reload_ready (GpkAsStore   *store,
+                           GAsyncResult *res,
+                           GTask        *task)
+{
+	GpkAsStoreReload *reload = NULL;
+	AsPool *as_pool = NULL;
+	GHashTable *packages_components = NULL;
+	gchar *cache_stamp = NULL;
+	GError *error = NULL;
+
+	reload = g_task_propagate_pointer (G_TASK (res), &error);
+	if (error != NULL) {
+		g_task_return_error (task, error);
+		goto out;
+	}
+
+	/* swap here, since the components are only used from this thread */
+	if (reload != NULL) {
+		g_mutex_lock (&store->pool_lock);
+		as_pool = store->as_pool;
+		store->as_pool = reload->as_pool;
+		reload->as_pool = as_pool;
+		packages_components = store->packages_components;
+		store->packages_components = reload->packages_components;
+		reload->packages_components = packages_components;
+		cache_stamp = store->cache_stamp;
+		store->cache_stamp = reload->cache_stamp;
+		reload->cache_stamp = cache_stamp;
+		g_mutex_unlock (&store->pool_lock);
+
+		gpk_as_store_reload_free (reload);
+	}
+
+	g_task_return_boolean (task, TRUE);
+
+out:
+	g_object_unref (task);
+}
+
+gboolean
+gpk_as_store_reload_finish (GpkAsStore    *store,
+                            GAsyncResult  *result,
+                            GError       **error)
+{
+	return g_task_propagate_boolean (G_TASK (result), error);
+}
+
+/**
+ * gpk_as_store_reload:
+ *
+ * Load the AppStream metadata again if it changed, for example after
+ * refresh the package cache.
+ **/
+void
+gpk_as_store_reload (GpkAsStore          *store,
+                     GCancellable        *cancellable,
+                     GAsyncReadyCallback  ready_callback,
+                     gpointer             user_data)
+{
+	GTask *task = NULL, *reload_task = NULL;
+
+	task = g_task_new (store, cancellable, ready_callback, user_data);
+	g_task_set_source_tag (task, gpk_as_store_reload);
+
+	reload_task = g_task_new (store, cancellable,
+	                          (GAsyncReadyCallback) gpk_as_store_reload_ready,
+	                          task);
+	g_task_run_in_thread (reload_task, gpk_as_store_reload_threaded);
+	g_object_unref (reload_task);
+}
+
 gchar *
 gpk_as_component_get_desktop_id (AsComponent *component)
 {
@@ -92,43 +652,145 @@ gpk_as_component_get_desktop_id (AsComponent *component)
 AsComponent *
 gpk_as_store_get_component_by_pkgname (GpkAsStore *store, const gchar *pkgname)
 {
-	return g_hash_table_lookup (store->packages_components, pkgname);
+	if (g_atomic_int_get (&store->pool_loaded))
+		return g_hash_table_lookup (store->packages_components, pkgname);
+
+	return gpk_as_store_get_cached_component (store, pkgname);
 }
 
-gchar **
-gpk_as_store_search_pkgnames_by_categories (GpkAsStore *store, gchar **includes, gchar **excludes)
+static void
+gpk_as_store_category_map_add (GHashTable *category_map, const gchar *category, const gchar *pkgname)
 {
-	GPtrArray *pkgname_list = NULL, *components = NULL;
+	GPtrArray *pkgnames = NULL;
+
+	pkgnames = g_hash_table_lookup (category_map, category);
+	if (pkgnames == NULL) {
+		pkgnames = g_ptr_array_new_with_free_func (g_free);
+		g_hash_table_insert (category_map, g_strdup (category), pkgnames);
+	}
+	g_ptr_array_add (pkgnames, g_strdup (pkgname));
+}
+
+/**
+ * gpk_as_store_get_category_map:
+ *
+ * Walk all the components once, and group the package names by each
+ * AppStream category. It uses the index cache if the pool is still
+ * loading, since both have the same components.
+ *
+ * Returns: a new table of category to a GPtrArray of package names
+ **/
+GHashTable *
+gpk_as_store_get_category_map (GpkAsStore *store, GError **error)
+{
+	GHashTable *category_map = NULL;
+	GPtrArray *components = NULL, *categories = NULL;
 	AsComponent *component = NULL;
-	GStrv category_ids = NULL;
-	const gchar *pkgname = NULL;
-	guint i = 0, j = 0;
+	GVariant *record = NULL;
+	GVariantIter *pkgnames_iter = NULL, *categories_iter = NULL;
+	const gchar *pkgname = NULL, *category = NULL;
+	gsize i = 0, j = 0;
+
+	category_map = g_hash_table_new_full (g_str_hash, g_str_equal,
+	                                      g_free, (GDestroyNotify) g_ptr_array_unref);
+
+	if (!g_atomic_int_get (&store->pool_loaded) && store->cache_records != NULL) {
+		for (i = 0; i < g_variant_n_children (store->cache_records); i++) {
+			record = g_variant_get_child_value (store->cache_records, i);
+			g_variant_get (record, "(&s&s&s&sasasa(uuuss))",
+			               NULL, NULL, NULL, NULL,
+			               &pkgnames_iter, &categories_iter, NULL);
+
+			/* as as_component_get_pkgname(), just the first one */
+			if (g_variant_iter_next (pkgnames_iter, "&s", &pkgname)) {
+				while (g_variant_iter_next (categories_iter, "&s", &category))
+					gpk_as_store_category_map_add (category_map, category, pkgname);
+			}
 
-	pkgname_list = g_ptr_array_new ();
+			g_variant_iter_free (pkgnames_iter);
+			g_variant_iter_free (categories_iter);
+			g_variant_unref (record);
+		}
+		goto out;
+	}
 
-	for (i = 0; includes[i] != NULL; i++) {
-		g_debug ("Include: %s", includes[i]);
+	if (!gpk_as_store_ensure_pool (store, NULL, error)) {
+		g_hash_table_unref (category_map);
+		category_map = NULL;
+		goto out;
+	}
 
-		category_ids = g_new0 (gchar *, 2);
-		category_ids[0] = g_strdup (includes[i]);
+	components = as_pool_get_components (store->as_pool);
+	for (i = 0; i < components->len; i++) {
+		component = AS_COMPONENT (g_ptr_array_index (components, i));
+		pkgname = as_component_get_pkgname (component);
+		if (pkgname == NULL)
+			continue;
 
-		components = as_pool_get_components_by_categories (store->as_pool, category_ids);
-		for (j = 0; j < components->len; j++) {
-			component = AS_COMPONENT (g_ptr_array_index (components, j));
-			pkgname = as_component_get_pkgname (component);
-			if (pkgname) {
-				g_ptr_array_add (pkgname_list, g_strdup(pkgname));
-			}
-		}
-		g_ptr_array_unref (components);
-		g_strfreev (category_ids);
+		categories = as_component_get_categories (component);
+		for (j = 0; j < categories->len; j++)
+			gpk_as_store_category_map_add (category_map, g_ptr_array_index (categories, j), pkgname);
 	}
+	g_ptr_array_unref (components);
 
-	g_debug ("Appstream packages: %u", pkgname_list->len);
+out:
+	if (category_map != NULL)
+		g_debug ("Appstream categories: %u", g_hash_table_size (category_map));
 
-	g_ptr_array_add (pkgname_list, NULL);
+	return category_map;
+}
 
-	return (char **) g_ptr_array_free (pkgname_list, FALSE);
+/**
+ * gpk_as_store_search_cache:
+ *
+ * A simpler search on the names, summaries and packages of the index
+ * cache, so searching does not wait for the pool that is still loading.
+ **/
+static void
+gpk_as_store_search_cache (GpkAsStore *store, const gchar *search, GPtrArray *pkgname_list)
+{
+	GVariant *record = NULL;
+	GVariantIter *pkgnames_iter = NULL;
+	const gchar *name = NULL, *summary = NULL, *pkgname = NULL;
+	gchar **tokens = NULL;
+	gchar *haystack = NULL, *folded = NULL;
+	gboolean matches;
+	gsize i = 0;
+	guint t = 0;
+
+	tokens = g_str_tokenize_and_fold (search, NULL, NULL);
+	if (tokens == NULL || tokens[0] == NULL)
+		goto out;
+
+	for (i = 0; i < g_variant_n_children (store->cache_records); i++) {
+		record = g_variant_get_child_value (store->cache_records, i);
+		g_variant_get (record, "(&s&s&s&sasasa(uuuss))",
+		               NULL, &name, &summary, NULL,
+		               &pkgnames_iter, NULL, NULL);
+
+		/* as as_component_get_pkgname(), just the first one */
+		if (g_variant_iter_next (pkgnames_iter, "&s", &pkgname)) {
+			haystack = g_strjoin (" ", name, summary, pkgname, NULL);
+			folded = g_utf8_casefold (haystack, -1);
+
+			matches = TRUE;
+			for (t = 0; tokens[t] != NULL && matches; t++)
+				matches = (strstr (folded, tokens[t]) != NULL);
+			if (matches)
+				g_ptr_array_add (pkgname_list, g_strdup (pkgname));
+
+			g_free (folded);
+			g_free (haystack);
+		}
+
+		g_variant_iter_free (pkgnames_iter);
+		g_variant_unref (record);
+	}
+
+	g_debug ("Appstream cached packages found: %u", pkgname_list->len);
+
+out:
+	g_strfreev (tokens);
 }
 
 gchar **
@@ -137,10 +799,23 @@ gpk_as_store_search_pkgnames (GpkAsStore *store, const gchar *search)
 	GPtrArray *pkgname_list = NULL, *components = NULL;
 	AsComponent *component = NULL;
 	const gchar *pkgname = NULL;
+	GError *error = NULL;
 	guint i = 0;
 
 	pkgname_list = g_ptr_array_new ();
 
+	/* do not block on the pool loading in the background */
+	if (!g_atomic_int_get (&store->pool_loaded) && store->cache_records != NULL) {
+		gpk_as_store_search_cache (store, search, pkgname_list);
+		goto out;
+	}
+
+	if (!gpk_as_store_ensure_pool (store, NULL, &error)) {
+		g_warning ("Failed to load appstream pool: %s", error->message);
+		g_error_free (error);
+		goto out;
+	}
+
 	components = as_pool_search (store->as_pool, search);
 	for (i = 0; i < components->len; i++) {
 		component = AS_COMPONENT (g_ptr_array_index (components, i));
@@ -149,7 +824,9 @@ gpk_as_store_search_pkgnames (GpkAsStore *store, const gchar *search)
 			g_ptr_array_add (pkgname_list, g_strdup(pkgname));
 		}
 	}
+	g_ptr_array_unref (components);
 
+out:
 	g_ptr_array_add (pkgname_list, NULL);
 
 	return (char **) g_ptr_array_free (pkgname_list, FALSE);
@@ -166,6 +843,14 @@ gpk_as_store_finalize (GObject *object)
 
 	g_hash_table_unref (store->packages_components);
 	g_object_unref (store->as_pool);
+	g_mutex_clear (&store->pool_lock);
+
+	g_hash_table_unref (store->cache_components);
+	g_hash_table_unref (store->cache_index);
+	if (store->cache_records != NULL)
+		g_variant_unref (store->cache_records);
+	g_mutex_clear (&store->cache_lock);
+	g_free (store->cache_stamp);
 
 	G_OBJECT_CLASS (gpk_as_store_parent_class)->finalize (object);
 }
@@ -175,6 +860,11 @@ gpk_as_store_init (GpkAsStore *store)
 {
 	store->as_pool = as_pool_new ();
 	store->packages_components = g_hash_table_new_full (g_str_hash, g_str_equal, (GDestroyNotify) g_free, (GDestroyNotify) g_object_unref);
+	g_mutex_init (&store->pool_lock);
+
+	store->cache_index = g_hash_table_new_full (g_str_hash, g_str_equal, (GDestroyNotify) g_free, NULL);
+	store->cache_components = g_hash_table_new_full (g_str_hash, g_str_equal, (GDestroyNotify) g_free, (GDestroyNotify) g_object_unref);
+	g_mutex_init (&store->cache_lock);
 }
 
 static void
@@ -37,14 +37,20 @@ gpk_as_store_new (void);
 gboolean
 gpk_as_store_load (GpkAsStore *store, GCancellable *cancellable, GError **error);
 
+void
+gpk_as_store_reload (GpkAsStore *store, GCancellable *cancellable, GAsyncReadyCallback ready_callback, gpointer user_data);
+
+gboolean
+gpk_as_store_reload_finish (GpkAsStore *store, GAsyncResult *result, GError **error);
+
 gchar *
 gpk_as_component_get_desktop_id (AsComponent *component);
 
 AsComponent *
 gpk_as_store_get_component_by_pkgname (GpkAsStore *store, const gchar *pkgname);
 
-gchar **
-gpk_as_store_search_pkgnames_by_categories (GpkAsStore *store, gchar **includes, gchar **excludes);
+GHashTable *
+gpk_as_store_get_category_map (GpkAsStore *store, GError **error);
 
 gchar **
 gpk_as_store_search_pkgnames (GpkAsStore *store, const gchar *search);
@@ -47,89 +47,120 @@ struct _GpkBackend
 	GObject			 parent;
 
 	PkTask			*task;
+	PkControl		*control;
 	GpkAsStore		*as_store;
 	GpkCategories		*categories;
+	GHashTable		*category_index;
 	GHashTable		*repos;
+
+	guint			 stages_finished;
+	gboolean		 background_refresh;
+
+	gboolean		 can_get_packages;
+	GHashTable		*packages;
+	GPtrArray		*packages_waiting;
+	guint			 packages_serial;
+};
+
+enum {
+	STAGE_FINISHED,
+	LAST_SIGNAL
 };
 
+static guint signals [LAST_SIGNAL] = { 0 };
+
 G_DEFINE_TYPE (GpkBackend, gpk_backend, G_TYPE_OBJECT)
 
-static void
-gpk_backend_open_threaded (GTask        *task,
-                           gpointer      source_object,
-                           gpointer      task_data,
-                           GCancellable *cancellable)
+#define GPK_BACKEND_STAGE_BIT(stage)	(1u << (stage))
+#define GPK_BACKEND_STAGE_ALL		(GPK_BACKEND_STAGE_BIT (GPK_BACKEND_STAGE_LAST) - 1)
+
+/* stages that must be finished before start each stage */
+static const guint gpk_backend_stage_depends[GPK_BACKEND_STAGE_LAST] = {
+	[GPK_BACKEND_STAGE_PROPERTIES] = 0,
+	[GPK_BACKEND_STAGE_REFRESH]    = GPK_BACKEND_STAGE_BIT (GPK_BACKEND_STAGE_PROPERTIES),
+	[GPK_BACKEND_STAGE_APPSTREAM]  = GPK_BACKEND_STAGE_BIT (GPK_BACKEND_STAGE_REFRESH),
+	[GPK_BACKEND_STAGE_CATEGORIES] = 0,
+	[GPK_BACKEND_STAGE_REPOS]      = GPK_BACKEND_STAGE_BIT (GPK_BACKEND_STAGE_PROPERTIES),
+	[GPK_BACKEND_STAGE_CATEGORY_INDEX] = GPK_BACKEND_STAGE_BIT (GPK_BACKEND_STAGE_APPSTREAM) |
+	                                     GPK_BACKEND_STAGE_BIT (GPK_BACKEND_STAGE_CATEGORIES)
+};
+
+typedef struct {
+	GTask			*task;
+	guint			 started;
+	guint			 finished;
+	guint			 running;
+	GError			*error;
+} GpkBackendOpenState;
+
+typedef struct {
+	gchar			**pkgnames;
+	PkProgressCallback	 progress_callback;
+	gpointer		 progress_user_data;
+} GpkBackendResolveHelper;
+
+static gboolean
+gpk_backend_check_properties (GpkBackend *backend, GCancellable *cancellable, GError **error)
 {
-	GpkBackend *backend = NULL;
 	PkControl *control = NULL;
-	PkResults *results = NULL;
-	PkRepoDetail *item = NULL;
 	PkBitfield roles = PK_ROLE_ENUM_UNKNOWN;
-	GPtrArray *array = NULL;
-	GError *error = NULL;
-	gchar *repo_id = NULL;
-	gchar *description = NULL;
-	guint i;
-
-	backend = GPK_BACKEND (source_object);
+	gboolean ret = FALSE;
 
 	/* get backend properties to known if meet requirements */
 	control = pk_control_new ();
-	if (!pk_control_get_properties (control, cancellable, &error)) {
+	if (!pk_control_get_properties (control, cancellable, error)) {
 		goto out;
 	}
 
 	g_object_get (control, "roles", &roles, NULL);
 
-	if (!pk_bitfield_contain (roles, PK_ROLE_ENUM_GET_DETAILS)) {
-		error = g_error_new (PK_CONTROL_ERROR,
-		                     PK_ERROR_ENUM_NOT_SUPPORTED,
-		                     _("The backend does not support some features necessary for the application to work."));
-		goto out;
-	}
-	if (!pk_bitfield_contain (roles, PK_ROLE_ENUM_SEARCH_NAME)) {
-		error = g_error_new (PK_CONTROL_ERROR,
-		                     PK_ERROR_ENUM_NOT_SUPPORTED,
-		                     _("The backend does not support some features necessary for the application to work."));
-		goto out;
-	}
-	if (!pk_bitfield_contain (roles, PK_ROLE_ENUM_RESOLVE)) {
-		error = g_error_new (PK_CONTROL_ERROR,
-		                     PK_ERROR_ENUM_NOT_SUPPORTED,
-		                     _("The backend does not support some features necessary for the application to work."));
+	/* without it the packages are always resolved by the daemon */
+	backend->can_get_packages = pk_bitfield_contain (roles, PK_ROLE_ENUM_GET_PACKAGES);
+
+	if (!pk_bitfield_contain (roles, PK_ROLE_ENUM_GET_DETAILS) ||
+	    !pk_bitfield_contain (roles, PK_ROLE_ENUM_SEARCH_NAME) ||
+	    !pk_bitfield_contain (roles, PK_ROLE_ENUM_RESOLVE)) {
+		g_set_error (error,
+		             PK_CONTROL_ERROR,
+		             PK_ERROR_ENUM_NOT_SUPPORTED,
+		             "%s", _("The backend does not support some features necessary for the application to work."));
 		goto out;
 	}
 
+	ret = TRUE;
+
+out:
+	g_object_unref (control);
+
+	return ret;
+}
+
+static gboolean
+gpk_backend_refresh_cache (GpkBackend *backend, GCancellable *cancellable, GError **error)
+{
+	PkResults *results = NULL;
+
 	/* Sync repositories if they are old */
 	results = pk_task_refresh_cache_sync (backend->task, FALSE,
 	                                      cancellable,
 	                                      NULL, NULL,
-	                                      &error);
-
-	if (error) {
-		goto out;
-	}
-
-	/* load appstream store */
-	if (!gpk_as_store_load (backend->as_store, cancellable, &error)) {
-		goto out;
-	}
+	                                      error);
+	if (results == NULL)
+		return FALSE;
 
-	/* load categories store */
-	if (!gpk_categories_load (backend->categories, &error)) {
-		goto out;
-	}
+	g_object_unref (results);
 
-	/* get repos, so we can show the full name in the package source box */
-	results = pk_client_get_repo_list (PK_CLIENT (backend->task),
-	                                   pk_bitfield_value (PK_FILTER_ENUM_NONE),
-	                                   cancellable,
-	                                   NULL, NULL,
-	                                   &error);
+	return TRUE;
+}
 
-	if (error) {
-		goto out;
-	}
+static void
+gpk_backend_add_repos_from_results (GpkBackend *backend, PkResults *results)
+{
+	PkRepoDetail *item = NULL;
+	GPtrArray *array = NULL;
+	gchar *repo_id = NULL;
+	gchar *description = NULL;
+	guint i;
 
 	array = pk_results_get_repo_detail_array (results);
 	for (i = 0; i < array->len; i++) {
@@ -141,26 +172,251 @@ gpk_backend_open_threaded (GTask        *task,
 
 		/* no problem, just no point adding as we will fallback to the repo_id */
 		if (description != NULL)
-			g_hash_table_insert (backend->repos, g_strdup (repo_id), g_strdup (description));
+			g_hash_table_replace (backend->repos, g_strdup (repo_id), g_strdup (description));
 
 		g_free (repo_id);
 		g_free (description);
 	}
 
+	g_ptr_array_unref (array);
+}
+
+static gboolean
+gpk_backend_load_repos (GpkBackend *backend, GCancellable *cancellable, GError **error)
+{
+	PkClient *client = NULL;
+	PkResults *results = NULL;
+
+	/* use an own client, since the task can be in use by other stage */
+	client = pk_client_new ();
+
+	/* get repos, so we can show the full name in the package source box */
+	results = pk_client_get_repo_list (client,
+	                                   pk_bitfield_value (PK_FILTER_ENUM_NONE),
+	                                   cancellable,
+	                                   NULL, NULL,
+	                                   error);
+	g_object_unref (client);
+
+	if (results == NULL)
+		return FALSE;
+
+	gpk_backend_add_repos_from_results (backend, results);
+
+	g_object_unref (results);
+
+	return TRUE;
+}
+
+static gint
+gpk_backend_pkgname_cmp (gconstpointer a, gconstpointer b)
+{
+	return g_strcmp0 (*(const gchar **) a, *(const gchar **) b);
+}
+
+/**
+ * gpk_backend_build_category_pkgnames:
+ *
+ * Join the packages of all the AppStream categories included in the
+ * category, or its own packages if is special.
+ *
+ * Returns: a sorted array of unique package names
+ **/
+static gchar **
+gpk_backend_build_category_pkgnames (GpkCategory *category, GHashTable *category_map)
+{
+	GHashTable *unique = NULL;
+	GPtrArray *result = NULL, *pkgnames = NULL;
+	gchar **includes = NULL, **packages = NULL;
+	guint i, j;
+
+	unique = g_hash_table_new (g_str_hash, g_str_equal);
+	result = g_ptr_array_new ();
+
+	packages = gpk_category_get_packages (category);
+	if (packages != NULL) {
+		for (i = 0; packages[i] != NULL; i++) {
+			if (g_hash_table_add (unique, packages[i]))
+				g_ptr_array_add (result, g_strdup (packages[i]));
+		}
+		goto out;
+	}
+
+	includes = gpk_category_get_categories (category);
+	for (i = 0; includes != NULL && includes[i] != NULL; i++) {
+		pkgnames = g_hash_table_lookup (category_map, includes[i]);
+		if (pkgnames == NULL)
+			continue;
+		for (j = 0; j < pkgnames->len; j++) {
+			if (g_hash_table_add (unique, g_ptr_array_index (pkgnames, j)))
+				g_ptr_array_add (result, g_strdup (g_ptr_array_index (pkgnames, j)));
+		}
+	}
+
 out:
-	if (array)
-		g_ptr_array_unref (array);
-	if (results)
-		g_object_unref (results);
-	if (control)
-		g_object_unref (control);
+	g_ptr_array_sort (result, gpk_backend_pkgname_cmp);
+	g_ptr_array_add (result, NULL);
+
+	g_hash_table_unref (unique);
+	g_strfreev (includes);
+	g_strfreev (packages);
+
+	return (gchar **) g_ptr_array_free (result, FALSE);
+}
+
+/**
+ * gpk_backend_build_category_index:
+ *
+ * Resolve the packages of every category once, so that showing a
+ * category is just a lookup.
+ **/
+static gboolean
+gpk_backend_build_category_index (GpkBackend *backend, GHashTable *category_index, GError **error)
+{
+	GHashTable *category_map = NULL;
+	GPtrArray *categories = NULL;
+	GpkCategory *category = NULL;
+	guint i;
+
+	category_map = gpk_as_store_get_category_map (backend->as_store, error);
+	if (category_map == NULL)
+		return FALSE;
+
+	categories = gpk_categories_get_principals (backend->categories);
+	for (i = 0; i < categories->len; i++) {
+		category = g_ptr_array_index (categories, i);
+		g_hash_table_insert (category_index,
+		                     gpk_category_get_id (category),
+		                     gpk_backend_build_category_pkgnames (category, category_map));
+	}
+
+	g_ptr_array_unref (categories);
+	g_hash_table_unref (category_map);
+
+	return TRUE;
+}
+
+static void
+gpk_backend_stage_threaded (GTask        *task,
+                            gpointer      source_object,
+                            gpointer      task_data,
+                            GCancellable *cancellable)
+{
+	GpkBackend *backend = GPK_BACKEND (source_object);
+	GpkBackendStage stage = GPOINTER_TO_UINT (task_data);
+	GError *error = NULL;
+	gboolean ret = FALSE;
+
+	switch (stage) {
+	case GPK_BACKEND_STAGE_PROPERTIES:
+		ret = gpk_backend_check_properties (backend, cancellable, &error);
+		break;
+	case GPK_BACKEND_STAGE_REFRESH:
+		ret = gpk_backend_refresh_cache (backend, cancellable, &error);
+		break;
+	case GPK_BACKEND_STAGE_APPSTREAM:
+		ret = gpk_as_store_load (backend->as_store, cancellable, &error);
+		break;
+	case GPK_BACKEND_STAGE_CATEGORIES:
+		ret = gpk_categories_load (backend->categories, &error);
+		break;
+	case GPK_BACKEND_STAGE_REPOS:
+		ret = gpk_backend_load_repos (backend, cancellable, &error);
+		break;
+	case GPK_BACKEND_STAGE_CATEGORY_INDEX:
+		ret = gpk_backend_build_category_index (backend, backend->category_index, &error);
+		break;
+	default:
+		g_assert_not_reached ();
+	}
 
-	if (error)
+	if (!ret)
 		g_task_return_error (task, error);
 	else
 		g_task_return_boolean (task, TRUE);
 }
 
+static void gpk_backend_open_schedule (GpkBackend *backend, GpkBackendOpenState *state);
+
+static void
+gpk_backend_stage_ready (GpkBackend          *backend,
+                         GAsyncResult        *res,
+                         GpkBackendOpenState *state)
+{
+	GpkBackendStage stage;
+	GError *error = NULL;
+
+	stage = GPOINTER_TO_UINT (g_task_get_task_data (G_TASK (res)));
+	state->running &= ~GPK_BACKEND_STAGE_BIT (stage);
+
+	if (!g_task_propagate_boolean (G_TASK (res), &error)) {
+		g_debug ("Backend stage %u failed: %s", stage, error->message);
+		/* just keep the first error, and don't start new stages */
+		if (state->error == NULL)
+			state->error = error;
+		else
+			g_error_free (error);
+	} else {
+		g_debug ("Backend stage %u finished", stage);
+		state->finished |= GPK_BACKEND_STAGE_BIT (stage);
+		backend->stages_finished |= GPK_BACKEND_STAGE_BIT (stage);
+		g_signal_emit (backend, signals [STAGE_FINISHED], 0, stage);
+	}
+
+	gpk_backend_open_schedule (backend, state);
+}
+
+/**
+ * gpk_backend_open_schedule:
+ *
+ * Start all the stages whose dependencies are finished, and return the
+ * open task when everything is done or a stage failed.
+ **/
+static void
+gpk_backend_open_schedule (GpkBackend *backend, GpkBackendOpenState *state)
+{
+	GTask *stage_task = NULL;
+	GTask *task = state->task;
+	guint stage;
+
+	if (state->error == NULL) {
+		for (stage = 0; stage < GPK_BACKEND_STAGE_LAST; stage++) {
+			if (state->started & GPK_BACKEND_STAGE_BIT (stage))
+				continue;
+			if ((state->finished & gpk_backend_stage_depends[stage]) != gpk_backend_stage_depends[stage])
+				continue;
+
+			state->started |= GPK_BACKEND_STAGE_BIT (stage);
+			state->running |= GPK_BACKEND_STAGE_BIT (stage);
+
+			stage_task = g_task_new (backend,
+			                         g_task_get_cancellable (task),
+			                         (GAsyncReadyCallback) gpk_backend_stage_ready,
+			                         state);
+			g_task_set_source_tag (stage_task, gpk_backend_open_schedule);
+			g_task_set_task_data (stage_task, GUINT_TO_POINTER (stage), NULL);
+			g_task_run_in_thread (stage_task, gpk_backend_stage_threaded);
+			g_object_unref (stage_task);
+		}
+	}
+
+	/* wait for the running stages before return */
+	if (state->running != 0)
+		return;
+
+	if (state->error != NULL) {
+		g_task_return_error (task, state->error);
+		state->error = NULL;
+	} else if (state->finished == GPK_BACKEND_STAGE_ALL) {
+		g_task_return_boolean (task, TRUE);
+	} else {
+		g_assert_not_reached ();
+	}
+
+	g_object_unref (task);
+	g_free (state);
+}
+
 const gchar *
 gpk_backend_get_full_repo_name (GpkBackend *backend, const gchar *repo_id)
 {
@@ -215,11 +471,19 @@ gpk_backend_search_pkgnames_with_component (GpkBackend *backend, const gchar *se
 	return gpk_as_store_search_pkgnames (backend->as_store, search);
 }
 
+/**
+ * gpk_backend_get_category_pkgnames:
+ *
+ * Only valid once the GPK_BACKEND_STAGE_CATEGORY_INDEX stage finished,
+ * wait for it in "stage-finished" instead of searching without it.
+ **/
 gchar **
-gpk_backend_search_pkgnames_by_categories (GpkBackend *backend, gchar **categories)
+gpk_backend_get_category_pkgnames (GpkBackend *backend, const gchar *id)
 {
 	g_return_val_if_fail (GPK_IS_BACKEND (backend), NULL);
-	return gpk_as_store_search_pkgnames_by_categories (backend->as_store, categories, NULL);
+	g_return_val_if_fail (gpk_backend_stage_is_finished (backend, GPK_BACKEND_STAGE_CATEGORY_INDEX), NULL);
+
+	return g_strdupv (g_hash_table_lookup (backend->category_index, id));
 }
 
 PkTask *
@@ -239,22 +503,483 @@ gpk_backend_open_finish (GpkBackend    *backend,
 	return g_task_propagate_boolean (G_TASK (result), error);
 }
 
+static gboolean
+gpk_backend_results_propagate_error (PkResults *results, GError **error)
+{
+	PkError *error_code = NULL;
+
+	error_code = pk_results_get_error_code (results);
+	if (error_code == NULL)
+		return TRUE;
+
+	g_set_error (error,
+	             PK_CLIENT_ERROR,
+	             pk_error_get_code (error_code),
+	             "%s", pk_error_get_details (error_code));
+	g_object_unref (error_code);
+
+	return FALSE;
+}
+
+static GHashTable *
+gpk_backend_new_category_index (void)
+{
+	return g_hash_table_new_full (g_str_hash, g_str_equal,
+	                              g_free, (GDestroyNotify) g_strfreev);
+}
+
+static void
+gpk_backend_rebuild_category_index_threaded (GTask        *task,
+                                             gpointer      source_object,
+                                             gpointer      task_data,
+                                             GCancellable *cancellable)
+{
+	GpkBackend *backend = GPK_BACKEND (source_object);
+	GHashTable *category_index = NULL;
+	GError *error = NULL;
+
+	category_index = gpk_backend_new_category_index ();
+	if (!gpk_backend_build_category_index (backend, category_index, &error)) {
+		g_hash_table_unref (category_index);
+		g_task_return_error (task, error);
+		return;
+	}
+
+	g_task_return_pointer (task, category_index, (GDestroyNotify) g_hash_table_unref);
+}
+
+static void
+gpk_backend_rebuild_category_index_ready (GpkBackend   *backend,
+                                          GAsyncResult *res,
+                                          GTask        *task)
+{
+	GHashTable *category_index = NULL;
+	GError *error = NULL;
+
+	category_index = g_task_propagate_pointer (G_TASK (res), &error);
+	if (category_index == NULL) {
+		/* keep the old index, the refresh itself worked */
+		g_warning ("failed to rebuild the category index: %s", error->message);
+		g_error_free (error);
+		goto out;
+	}
+
+	g_hash_table_unref (backend->category_index);
+	backend->category_index = category_index;
+	g_signal_emit (backend, signals [STAGE_FINISHED], 0, GPK_BACKEND_STAGE_CATEGORY_INDEX);
+
+out:
+	g_task_return_boolean (task, TRUE);
+	g_object_unref (task);
+}
+
+static void
+gpk_backend_refresh_appstream_cb (GpkAsStore   *as_store,
+                                  GAsyncResult *res,
+                                  GTask        *task)
+{
+	GpkBackend *backend = GPK_BACKEND (g_task_get_source_object (task));
+	GTask *index_task = NULL;
+	GError *error = NULL;
+
+	if (!gpk_as_store_reload_finish (as_store, res, &error)) {
+		g_warning ("failed to reload appstream: %s", error->message);
+		g_error_free (error);
+		g_task_return_boolean (task, TRUE);
+		g_object_unref (task);
+		return;
+	}
+
+	/* the categories can have other packages now */
+	index_task = g_task_new (backend,
+	                         g_task_get_cancellable (task),
+	                         (GAsyncReadyCallback) gpk_backend_rebuild_category_index_ready,
+	                         task);
+	g_task_run_in_thread (index_task, gpk_backend_rebuild_category_index_threaded);
+	g_object_unref (index_task);
+}
+
+static void
+gpk_backend_refresh_repos_cb (PkClient     *client,
+                              GAsyncResult *res,
+                              GTask        *task)
+{
+	GpkBackend *backend = GPK_BACKEND (g_task_get_source_object (task));
+	PkResults *results = NULL;
+	GError *error = NULL;
+
+	results = pk_client_generic_finish (client, res, &error);
+	if (results == NULL || !gpk_backend_results_propagate_error (results, &error)) {
+		g_task_return_error (task, error);
+		g_object_unref (task);
+		goto out;
+	}
+
+	/* update the names, keeping the repos already known */
+	gpk_backend_add_repos_from_results (backend, results);
+
+	/* the new metadata can bring new versions */
+	gpk_backend_invalidate_packages (backend);
+
+	/* and new AppStream metadata, that was loaded before the refresh */
+	gpk_as_store_reload (backend->as_store,
+	                     g_task_get_cancellable (task),
+	                     (GAsyncReadyCallback) gpk_backend_refresh_appstream_cb,
+	                     task);
+
+out:
+	if (results != NULL)
+		g_object_unref (results);
+}
+
+static void
+gpk_backend_refresh_cache_cb (PkTask       *pk_task,
+                              GAsyncResult *res,
+                              GTask        *task)
+{
+	PkResults *results = NULL;
+	GError *error = NULL;
+
+	results = pk_task_generic_finish (pk_task, res, &error);
+	if (results == NULL || !gpk_backend_results_propagate_error (results, &error)) {
+		g_task_return_error (task, error);
+		g_object_unref (task);
+		goto out;
+	}
+
+	/* the refresh could add new repos */
+	pk_client_get_repo_list_async (PK_CLIENT (pk_task),
+	                               pk_bitfield_value (PK_FILTER_ENUM_NONE),
+	                               g_task_get_cancellable (task),
+	                               NULL, NULL,
+	                               (GAsyncReadyCallback) gpk_backend_refresh_repos_cb,
+	                               task);
+
+out:
+	if (results != NULL)
+		g_object_unref (results);
+}
+
+gboolean
+gpk_backend_refresh_finish (GpkBackend    *backend,
+                            GAsyncResult  *result,
+                            GError       **error)
+{
+	g_return_val_if_fail (GPK_IS_BACKEND (backend), FALSE);
+
+	return g_task_propagate_boolean (G_TASK (result), error);
+}
+
+/**
+ * gpk_backend_refresh:
+ *
+ * Refresh the package cache if it is old, and then update the repos.
+ **/
+void
+gpk_backend_refresh (GpkBackend          *backend,
+                     GCancellable        *cancellable,
+                     PkProgressCallback   progress_callback,
+                     gpointer             progress_user_data,
+                     GAsyncReadyCallback  ready_callback,
+                     gpointer             user_data)
+{
+	GTask *task = NULL;
+
+	g_return_if_fail (GPK_IS_BACKEND (backend));
+	g_return_if_fail (!cancellable || G_IS_CANCELLABLE (cancellable));
+
+	task = g_task_new (backend, cancellable, ready_callback, user_data);
+	g_task_set_source_tag (task, gpk_backend_refresh);
+
+	pk_task_refresh_cache_async (backend->task, FALSE,
+	                             cancellable,
+	                             progress_callback, progress_user_data,
+	                             (GAsyncReadyCallback) gpk_backend_refresh_cache_cb,
+	                             task);
+}
+
+static void
+gpk_backend_resolve_helper_free (GpkBackendResolveHelper *helper)
+{
+	g_strfreev (helper->pkgnames);
+	g_free (helper);
+}
+
+static GPtrArray *
+gpk_backend_resolve_local (GpkBackend *backend, gchar **pkgnames)
+{
+	GPtrArray *array = NULL, *packages = NULL;
+	guint i, j;
+
+	array = g_ptr_array_new_with_free_func (g_object_unref);
+	for (i = 0; pkgnames != NULL && pkgnames[i] != NULL; i++) {
+		packages = g_hash_table_lookup (backend->packages, pkgnames[i]);
+		if (packages == NULL)
+			continue;
+		for (j = 0; j < packages->len; j++)
+			g_ptr_array_add (array, g_object_ref (g_ptr_array_index (packages, j)));
+	}
+
+	return array;
+}
+
+static void
+gpk_backend_resolve_remote_cb (PkTask       *pk_task,
+                               GAsyncResult *res,
+                               GTask        *task)
+{
+	PkResults *results = NULL;
+	GError *error = NULL;
+
+	results = pk_task_generic_finish (pk_task, res, &error);
+	if (results == NULL || !gpk_backend_results_propagate_error (results, &error)) {
+		g_task_return_error (task, error);
+		goto out;
+	}
+
+	g_task_return_pointer (task,
+	                       pk_results_get_package_array (results),
+	                       (GDestroyNotify) g_ptr_array_unref);
+
+out:
+	if (results != NULL)
+		g_object_unref (results);
+	g_object_unref (task);
+}
+
+static void
+gpk_backend_resolve_remote (GpkBackend *backend, GTask *task)
+{
+	GpkBackendResolveHelper *helper = g_task_get_task_data (task);
+
+	pk_task_resolve_async (backend->task,
+	                       pk_bitfield_from_enums (PK_FILTER_ENUM_NEWEST,
+	                                               PK_FILTER_ENUM_ARCH,
+	                                               -1),
+	                       helper->pkgnames,
+	                       g_task_get_cancellable (task),
+	                       helper->progress_callback, helper->progress_user_data,
+	                       (GAsyncReadyCallback) gpk_backend_resolve_remote_cb,
+	                       task);
+}
+
+static void
+gpk_backend_get_packages_cb (PkClient     *client,
+                             GAsyncResult *res,
+                             GpkBackend   *backend)
+{
+	GpkBackendResolveHelper *helper = NULL;
+	PkResults *results = NULL;
+	PkPackage *package = NULL;
+	GHashTable *packages = NULL;
+	GPtrArray *array = NULL, *waiting = NULL, *by_name = NULL;
+	GError *error = NULL;
+	GTask *task = NULL;
+	guint serial;
+	guint i;
+
+	waiting = backend->packages_waiting;
+	backend->packages_waiting = NULL;
+
+	serial = GPOINTER_TO_UINT (g_object_get_data (G_OBJECT (client), "serial"));
+
+	results = pk_client_generic_finish (client, res, &error);
+	if (results == NULL || !gpk_backend_results_propagate_error (results, &error)) {
+		g_warning ("failed to get packages: %s", error->message);
+		g_error_free (error);
+		goto out;
+	}
+
+	/* the state changed while it was loading */
+	if (serial != backend->packages_serial) {
+		g_debug ("ignoring outdated packages");
+		goto out;
+	}
+
+	packages = g_hash_table_new_full (g_str_hash, g_str_equal,
+	                                  g_free, (GDestroyNotify) g_ptr_array_unref);
+
+	array = pk_results_get_package_array (results);
+	for (i = 0; i < array->len; i++) {
+		package = g_ptr_array_index (array, i);
+		by_name = g_hash_table_lookup (packages, pk_package_get_name (package));
+		if (by_name == NULL) {
+			by_name = g_ptr_array_new_with_free_func (g_object_unref);
+			g_hash_table_insert (packages, g_strdup (pk_package_get_name (package)), by_name);
+		}
+		g_ptr_array_add (by_name, g_object_ref (package));
+	}
+
+	g_debug ("Package state cache loaded with %u names", g_hash_table_size (packages));
+
+	if (backend->packages != NULL)
+		g_hash_table_unref (backend->packages);
+	backend->packages = packages;
+
+out:
+	/* serve the resolves that were waiting for the packages */
+	for (i = 0; i < waiting->len; i++) {
+		task = g_ptr_array_index (waiting, i);
+		if (g_task_return_error_if_cancelled (task)) {
+			g_object_unref (task);
+		} else if (backend->packages != NULL) {
+			helper = g_task_get_task_data (task);
+			g_task_return_pointer (task,
+			                       gpk_backend_resolve_local (backend, helper->pkgnames),
+			                       (GDestroyNotify) g_ptr_array_unref);
+			g_object_unref (task);
+		} else {
+			gpk_backend_resolve_remote (backend, task);
+		}
+	}
+
+	g_ptr_array_unref (waiting);
+	if (array != NULL)
+		g_ptr_array_unref (array);
+	if (results != NULL)
+		g_object_unref (results);
+	g_object_unref (client);
+	g_object_unref (backend);
+}
+
+/**
+ * gpk_backend_invalidate_packages:
+ *
+ * Forget the state of the packages, since something was installed,
+ * removed or updated.
+ **/
+void
+gpk_backend_invalidate_packages (GpkBackend *backend)
+{
+	g_return_if_fail (GPK_IS_BACKEND (backend));
+
+	g_debug ("Package state cache invalidated");
+
+	backend->packages_serial++;
+	if (backend->packages != NULL) {
+		g_hash_table_unref (backend->packages);
+		backend->packages = NULL;
+	}
+}
+
+static void
+gpk_backend_packages_changed_cb (PkControl *control, GpkBackend *backend)
+{
+	gpk_backend_invalidate_packages (backend);
+}
+
+GPtrArray *
+gpk_backend_resolve_finish (GpkBackend    *backend,
+                            GAsyncResult  *result,
+                            GError       **error)
+{
+	g_return_val_if_fail (GPK_IS_BACKEND (backend), NULL);
+
+	return g_task_propagate_pointer (G_TASK (result), error);
+}
+
+/**
+ * gpk_backend_resolve:
+ *
+ * Get the newest packages with these names, as pk_task_resolve_async()
+ * would do. All the packages are fetched once, and then the names are
+ * resolved locally until the state of the packages change.
+ **/
+void
+gpk_backend_resolve (GpkBackend          *backend,
+                     gchar              **pkgnames,
+                     GCancellable        *cancellable,
+                     PkProgressCallback   progress_callback,
+                     gpointer             progress_user_data,
+                     GAsyncReadyCallback  ready_callback,
+                     gpointer             user_data)
+{
+	GpkBackendResolveHelper *helper = NULL;
+	PkClient *client = NULL;
+	GTask *task = NULL;
+
+	g_return_if_fail (GPK_IS_BACKEND (backend));
+	g_return_if_fail (!cancellable || G_IS_CANCELLABLE (cancellable));
+
+	helper = g_new0 (GpkBackendResolveHelper, 1);
+	helper->pkgnames = g_strdupv (pkgnames);
+	helper->progress_callback = progress_callback;
+	helper->progress_user_data = progress_user_data;
+
+	task = g_task_new (backend, cancellable, ready_callback, user_data);
+	g_task_set_source_tag (task, gpk_backend_resolve);
+	g_task_set_task_data (task, helper, (GDestroyNotify) gpk_backend_resolve_helper_free);
+
+	if (backend->packages != NULL) {
+		g_task_return_pointer (task,
+		                       gpk_backend_resolve_local (backend, pkgnames),
+		                       (GDestroyNotify) g_ptr_array_unref);
+		g_object_unref (task);
+		return;
+	}
+
+	if (!backend->can_get_packages) {
+		gpk_backend_resolve_remote (backend, task);
+		return;
+	}
+
+	/* wait with the others for the packages, showing the progress
+	 * to the first one, that started it */
+	if (backend->packages_waiting == NULL) {
+		backend->packages_waiting = g_ptr_array_new ();
+
+		/* use an own client, since the task can be in use by a resolve */
+		client = pk_client_new ();
+		g_object_set_data (G_OBJECT (client), "serial",
+		                   GUINT_TO_POINTER (backend->packages_serial));
+		pk_client_get_packages_async (client,
+		                              pk_bitfield_from_enums (PK_FILTER_ENUM_NEWEST,
+		                                                      PK_FILTER_ENUM_ARCH,
+		                                                      -1),
+		                              NULL,
+		                              progress_callback, progress_user_data,
+		                              (GAsyncReadyCallback) gpk_backend_get_packages_cb,
+		                              g_object_ref (backend));
+	}
+	g_ptr_array_add (backend->packages_waiting, task);
+}
+
+void
+gpk_backend_set_background_refresh (GpkBackend *backend, gboolean background_refresh)
+{
+	g_return_if_fail (GPK_IS_BACKEND (backend));
+	backend->background_refresh = background_refresh;
+}
+
+gboolean
+gpk_backend_stage_is_finished (GpkBackend *backend, GpkBackendStage stage)
+{
+	g_return_val_if_fail (GPK_IS_BACKEND (backend), FALSE);
+	return (backend->stages_finished & GPK_BACKEND_STAGE_BIT (stage)) != 0;
+}
+
 void
 gpk_backend_open (GpkBackend          *backend,
                   GCancellable        *cancellable,
                   GAsyncReadyCallback  ready_callback,
                   gpointer             user_data)
 {
-	GTask *task = NULL;
+	GpkBackendOpenState *state = NULL;
 
 	g_return_if_fail (GPK_IS_BACKEND (backend));
 	g_return_if_fail (!cancellable || G_IS_CANCELLABLE (cancellable));
 
-	task = g_task_new (backend, cancellable, ready_callback, user_data);
-	g_task_set_source_tag (task, gpk_backend_open);
-	g_task_run_in_thread (task, gpk_backend_open_threaded);
+	state = g_new0 (GpkBackendOpenState, 1);
+	state->task = g_task_new (backend, cancellable, ready_callback, user_data);
+	g_task_set_source_tag (state->task, gpk_backend_open);
 
-	g_object_unref (task);
+	/* the refresh will be done later with gpk_backend_refresh() */
+	if (backend->background_refresh) {
+		state->started |= GPK_BACKEND_STAGE_BIT (GPK_BACKEND_STAGE_REFRESH);
+		state->finished |= GPK_BACKEND_STAGE_BIT (GPK_BACKEND_STAGE_REFRESH);
+	}
+
+	gpk_backend_open_schedule (backend, state);
 }
 
 static void
@@ -269,12 +994,21 @@ gpk_backend_finalize (GObject *object)
 	if (backend->task != NULL)
 		g_object_unref (backend->task);
 
+	if (backend->control != NULL)
+		g_object_unref (backend->control);
+
+	if (backend->packages != NULL)
+		g_hash_table_unref (backend->packages);
+
 	if (backend->as_store != NULL)
 		g_object_unref (backend->as_store);
 
 	if (backend->categories != NULL)
 		g_object_unref (backend->categories);
 
+	if (backend->category_index != NULL)
+		g_hash_table_unref (backend->category_index);
+
 	if (backend->repos != NULL)
 		g_hash_table_destroy (backend->repos);
 
@@ -290,9 +1024,17 @@ gpk_backend_init (GpkBackend *backend)
 	              "background", FALSE,
 	              NULL);
 
+	/* the state of the packages is cached until it changes */
+	backend->control = pk_control_new ();
+	g_signal_connect (backend->control, "updates-changed",
+	                  G_CALLBACK (gpk_backend_packages_changed_cb), backend);
+	g_signal_connect (backend->control, "repo-list-changed",
+	                  G_CALLBACK (gpk_backend_packages_changed_cb), backend);
+
 	backend->as_store = gpk_as_store_new ();
 
 	backend->categories = gpk_categories_new ();
+	backend->category_index = gpk_backend_new_category_index ();
 
 	backend->repos = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, g_free);
 }
@@ -302,6 +1044,12 @@ gpk_backend_class_init (GpkBackendClass *klass)
 {
 	GObjectClass *object_class = G_OBJECT_CLASS (klass);
 	object_class->finalize = gpk_backend_finalize;
+
+	signals [STAGE_FINISHED] =
+		g_signal_new ("stage-finished",
+		              G_TYPE_FROM_CLASS (object_class), G_SIGNAL_RUN_LAST,
+		              0, NULL, NULL, g_cclosure_marshal_VOID__UINT,
+		              G_TYPE_NONE, 1, G_TYPE_UINT);
 }
 
 GpkBackend *
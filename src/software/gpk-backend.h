@@ -24,6 +24,7 @@
 
 #include <glib-object.h>
 #include <appstream.h>
+#include <packagekit-glib2/packagekit.h>
 
 #include "gpk-categories.h"
 
@@ -32,6 +33,16 @@ G_BEGIN_DECLS
 #define GPK_TYPE_BACKEND (gpk_backend_get_type())
 G_DECLARE_FINAL_TYPE (GpkBackend, gpk_backend, GPK, BACKEND, GObject)
 
+typedef enum {
+	GPK_BACKEND_STAGE_PROPERTIES,
+	GPK_BACKEND_STAGE_REFRESH,
+	GPK_BACKEND_STAGE_APPSTREAM,
+	GPK_BACKEND_STAGE_CATEGORIES,
+	GPK_BACKEND_STAGE_REPOS,
+	GPK_BACKEND_STAGE_CATEGORY_INDEX,
+	GPK_BACKEND_STAGE_LAST
+} GpkBackendStage;
+
 AsComponent *
 gpk_backend_get_component_by_pkgname (GpkBackend *backend, const gchar *pkgname);
 
@@ -45,7 +56,7 @@ gchar **
 gpk_backend_search_pkgnames_with_component (GpkBackend *backend, const gchar *search);
 
 gchar **
-gpk_backend_search_pkgnames_by_categories (GpkBackend *backend, gchar **categories);
+gpk_backend_get_category_pkgnames (GpkBackend *backend, const gchar *id);
 
 const gchar *
 gpk_backend_get_full_repo_name (GpkBackend *backend, const gchar *repo_id);
@@ -53,6 +64,42 @@ gpk_backend_get_full_repo_name (GpkBackend *backend, const gchar *repo_id);
 PkTask *
 gpk_backend_get_task (GpkBackend *backend);
 
+void
+gpk_backend_invalidate_packages (GpkBackend *backend);
+
+GPtrArray *
+gpk_backend_resolve_finish (GpkBackend    *backend,
+                            GAsyncResult  *result,
+                            GError       **error);
+
+void
+gpk_backend_resolve (GpkBackend          *backend,
+                     gchar              **pkgnames,
+                     GCancellable        *cancellable,
+                     PkProgressCallback   progress_callback,
+                     gpointer             progress_user_data,
+                     GAsyncReadyCallback  ready_callback,
+                     gpointer             user_data);
+
+void
+gpk_backend_set_background_refresh (GpkBackend *backend, gboolean background_refresh);
+
+gboolean
+gpk_backend_refresh_finish (GpkBackend    *backend,
+                            GAsyncResult  *result,
+                            GError       **error);
+
+void
+gpk_backend_refresh (GpkBackend          *backend,
+                     GCancellable        *cancellable,
+                     PkProgressCallback   progress_callback,
+                     gpointer             progress_user_data,
+                     GAsyncReadyCallback  ready_callback,
+                     gpointer             user_data);
+
+gboolean
+gpk_backend_stage_is_finished (GpkBackend *backend, GpkBackendStage stage);
+
 gboolean
 gpk_backend_open_finish (GpkBackend    *backend,
                          GAsyncResult  *result,
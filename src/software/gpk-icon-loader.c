@@ -0,0 +1,567 @@
+/* -*- Mode: C; tab-width: 8; indent-tabs-mode: t; c-basic-offset: 8 -*-
+ *
+ * Copyright (C) 2024 Matias De lellis <mati86dl@gmail.com>
+ *
+ * Licensed under the GNU General Public License Version 2
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "config.h"
+
+#include <string.h>
+#include <glib.h>
+#include <glib/gstdio.h>
+
+#include "gpk-icon-loader.h"
+
+/* scaled icons kept in memory, shared by all the searches */
+#define GPK_ICON_LOADER_CACHE_SIZE	512
+#define GPK_ICON_LOADER_MAX_THREADS	4
+
+/* pre-scaled icons saved on disk, as raw pixels to avoid decode them */
+#define GPK_ICON_LOADER_THUMB_VERSION	1
+#define GPK_ICON_LOADER_THUMB_TYPE	"(uxsuuubay)"
+/* and pruned when they are old, or too many */
+#define GPK_ICON_LOADER_THUMB_MAX_AGE	(30 * 24 * 60 * 60)
+#define GPK_ICON_LOADER_THUMB_MAX_SIZE	(32 * 1024 * 1024)
+
+static void     gpk_icon_loader_finalize	(GObject	  *object);
+
+struct _GpkIconLoader
+{
+	GObject			 parent;
+
+	GThreadPool		*pool;
+	gchar			*thumbs_dir;
+
+	GMutex			 cache_lock;
+	GQueue			*cache_lru;
+	GHashTable		*cache;
+};
+
+typedef struct {
+	gchar			*key;
+	GdkPixbuf		*pixbuf;
+} GpkIconLoaderEntry;
+
+typedef struct {
+	gchar			*id;
+	gchar			*filename;
+	gint			 size;
+} GpkIconLoaderRequest;
+
+typedef struct {
+	gchar			*filename;
+	gint64			 mtime;
+	goffset			 size;
+} GpkIconLoaderThumb;
+
+G_DEFINE_TYPE (GpkIconLoader, gpk_icon_loader, G_TYPE_OBJECT)
+
+static gchar *
+gpk_icon_loader_get_key (const gchar *filename, gint size)
+{
+	return g_strdup_printf ("%i:%s", size, filename);
+}
+
+static void
+gpk_icon_loader_entry_free (GpkIconLoaderEntry *entry)
+{
+	g_free (entry->key);
+	g_object_unref (entry->pixbuf);
+	g_free (entry);
+}
+
+static void
+gpk_icon_loader_request_free (GpkIconLoaderRequest *request)
+{
+	g_free (request->id);
+	g_free (request->filename);
+	g_free (request);
+}
+
+static GdkPixbuf *
+gpk_icon_loader_cache_lookup (GpkIconLoader *loader, const gchar *key)
+{
+	GpkIconLoaderEntry *entry;
+	GdkPixbuf *pixbuf = NULL;
+	GList *link;
+
+	g_mutex_lock (&loader->cache_lock);
+
+	link = g_hash_table_lookup (loader->cache, key);
+	if (link != NULL) {
+		/* most recently used at the head */
+		g_queue_unlink (loader->cache_lru, link);
+		g_queue_push_head_link (loader->cache_lru, link);
+
+		entry = link->data;
+		pixbuf = g_object_ref (entry->pixbuf);
+	}
+
+	g_mutex_unlock (&loader->cache_lock);
+
+	return pixbuf;
+}
+
+static void
+gpk_icon_loader_cache_insert (GpkIconLoader *loader, const gchar *key, GdkPixbuf *pixbuf)
+{
+	GpkIconLoaderEntry *entry;
+
+	g_mutex_lock (&loader->cache_lock);
+
+	/* other worker could load it in the meantime */
+	if (g_hash_table_contains (loader->cache, key))
+		goto out;
+
+	entry = g_new0 (GpkIconLoaderEntry, 1);
+	entry->key = g_strdup (key);
+	entry->pixbuf = g_object_ref (pixbuf);
+
+	g_queue_push_head (loader->cache_lru, entry);
+	g_hash_table_insert (loader->cache, entry->key, loader->cache_lru->head);
+
+	/* drop the least recently used */
+	while (g_queue_get_length (loader->cache_lru) > GPK_ICON_LOADER_CACHE_SIZE) {
+		entry = g_queue_pop_tail (loader->cache_lru);
+		g_hash_table_remove (loader->cache, entry->key);
+		gpk_icon_loader_entry_free (entry);
+	}
+
+out:
+	g_mutex_unlock (&loader->cache_lock);
+}
+
+static gchar *
+gpk_icon_loader_get_thumb_filename (GpkIconLoader *loader, const gchar *id, gint size)
+{
+	gchar *size_dir, *basename, *filename;
+
+	size_dir = g_strdup_printf ("%i", size);
+	basename = g_strdelimit (g_strdup (id), G_DIR_SEPARATOR_S, '_');
+	filename = g_build_filename (loader->thumbs_dir, size_dir, basename, NULL);
+
+	g_free (size_dir);
+	g_free (basename);
+
+	return filename;
+}
+
+/**
+ * gpk_icon_loader_load_thumb:
+ *
+ * Returns: the pre-scaled icon if it was saved from the same source file.
+ **/
+static GdkPixbuf *
+gpk_icon_loader_load_thumb (const gchar *thumb_filename, const gchar *filename, gint64 mtime)
+{
+	GMappedFile *mapped = NULL;
+	GBytes *bytes = NULL, *pixels = NULL;
+	GVariant *thumb = NULL, *pixels_variant = NULL;
+	GdkPixbuf *pixbuf = NULL;
+	const gchar *thumb_source = NULL;
+	guint32 version = 0, width = 0, height = 0, rowstride = 0;
+	gint64 thumb_mtime = 0;
+	gboolean has_alpha = FALSE;
+	gsize expected = 0;
+
+	mapped = g_mapped_file_new (thumb_filename, FALSE, NULL);
+	if (mapped == NULL)
+		return NULL;
+
+	bytes = g_mapped_file_get_bytes (mapped);
+	thumb = g_variant_ref_sink (g_variant_new_from_bytes (G_VARIANT_TYPE (GPK_ICON_LOADER_THUMB_TYPE), bytes, FALSE));
+
+	g_variant_get (thumb, "(ux&suuub@ay)",
+	               &version, &thumb_mtime, &thumb_source,
+	               &width, &height, &rowstride, &has_alpha,
+	               &pixels_variant);
+
+	if (version != GPK_ICON_LOADER_THUMB_VERSION ||
+	    thumb_mtime != mtime ||
+	    g_strcmp0 (thumb_source, filename) != 0)
+		goto out;
+
+	/* never trust the size of the pixels */
+	if (width == 0 || height == 0 || rowstride < width * (has_alpha ? 4 : 3))
+		goto out;
+	expected = (gsize) rowstride * (height - 1) + width * (has_alpha ? 4 : 3);
+
+	pixels = g_variant_get_data_as_bytes (pixels_variant);
+	if (g_bytes_get_size (pixels) != expected)
+		goto out;
+
+	pixbuf = gdk_pixbuf_new_from_bytes (pixels,
+	                                    GDK_COLORSPACE_RGB,
+	                                    has_alpha, 8,
+	                                    (gint) width, (gint) height,
+	                                    (gint) rowstride);
+
+out:
+	if (pixels != NULL)
+		g_bytes_unref (pixels);
+	if (pixels_variant != NULL)
+		g_variant_unref (pixels_variant);
+	g_variant_unref (thumb);
+	g_bytes_unref (bytes);
+	g_mapped_file_unref (mapped);
+
+	return pixbuf;
+}
+
+static void
+gpk_icon_loader_save_thumb (const gchar *thumb_filename, const gchar *filename, gint64 mtime, GdkPixbuf *pixbuf)
+{
+	GBytes *pixels = NULL;
+	GVariant *thumb = NULL;
+	GError *error = NULL;
+	gchar *dirname = NULL;
+
+	/* only the usual pixbufs can be saved as raw pixels */
+	if (gdk_pixbuf_get_colorspace (pixbuf) != GDK_COLORSPACE_RGB ||
+	    gdk_pixbuf_get_bits_per_sample (pixbuf) != 8)
+		return;
+
+	dirname = g_path_get_dirname (thumb_filename);
+	if (g_mkdir_with_parents (dirname, 0700) != 0) {
+		g_debug ("failed to create %s", dirname);
+		goto out;
+	}
+
+	pixels = gdk_pixbuf_read_pixel_bytes (pixbuf);
+	thumb = g_variant_ref_sink (g_variant_new ("(uxsuuub@ay)",
+	                                           GPK_ICON_LOADER_THUMB_VERSION,
+	                                           mtime,
+	                                           filename,
+	                                           (guint32) gdk_pixbuf_get_width (pixbuf),
+	                                           (guint32) gdk_pixbuf_get_height (pixbuf),
+	                                           (guint32) gdk_pixbuf_get_rowstride (pixbuf),
+	                                           gdk_pixbuf_get_has_alpha (pixbuf),
+	                                           g_variant_new_from_bytes (G_VARIANT_TYPE_BYTESTRING, pixels, TRUE)));
+
+	if (!g_file_set_contents (thumb_filename,
+	                          g_variant_get_data (thumb),
+	                          (gssize) g_variant_get_size (thumb),
+	                          &error)) {
+		g_debug ("failed to save icon thumbnail: %s", error->message);
+		g_error_free (error);
+	}
+
+out:
+	if (thumb != NULL)
+		g_variant_unref (thumb);
+	if (pixels != NULL)
+		g_bytes_unref (pixels);
+	g_free (dirname);
+}
+
+static GdkPixbuf *
+gpk_icon_loader_load_pixbuf (GpkIconLoader *loader, GpkIconLoaderRequest *request, GError **error)
+{
+	GdkPixbuf *pixbuf = NULL;
+	GStatBuf st;
+	gchar *thumb_filename = NULL;
+	gint64 mtime = 0;
+
+	if (request->id != NULL && g_stat (request->filename, &st) == 0) {
+		mtime = (gint64) st.st_mtime;
+		thumb_filename = gpk_icon_loader_get_thumb_filename (loader, request->id, request->size);
+		pixbuf = gpk_icon_loader_load_thumb (thumb_filename, request->filename, mtime);
+		if (pixbuf != NULL)
+			goto out;
+	}
+
+	pixbuf = gdk_pixbuf_new_from_file_at_scale (request->filename,
+	                                            request->size,
+	                                            request->size,
+	                                            FALSE,
+	                                            error);
+	if (pixbuf == NULL)
+		goto out;
+
+	if (thumb_filename != NULL)
+		gpk_icon_loader_save_thumb (thumb_filename, request->filename, mtime, pixbuf);
+
+out:
+	g_free (thumb_filename);
+
+	return pixbuf;
+}
+
+static void
+gpk_icon_loader_worker (GTask *task, GpkIconLoader *loader)
+{
+	GpkIconLoaderRequest *request;
+	GdkPixbuf *pixbuf = NULL;
+	GError *error = NULL;
+	gchar *key = NULL;
+
+	if (g_task_return_error_if_cancelled (task))
+		goto out;
+
+	request = g_task_get_task_data (task);
+	key = gpk_icon_loader_get_key (request->filename, request->size);
+
+	/* could be already loaded by other request */
+	pixbuf = gpk_icon_loader_cache_lookup (loader, key);
+	if (pixbuf == NULL) {
+		pixbuf = gpk_icon_loader_load_pixbuf (loader, request, &error);
+		if (pixbuf == NULL) {
+			g_task_return_error (task, error);
+			goto out;
+		}
+		gpk_icon_loader_cache_insert (loader, key, pixbuf);
+	}
+
+	g_task_return_pointer (task, pixbuf, g_object_unref);
+
+out:
+	g_free (key);
+	g_object_unref (task);
+}
+
+/**
+ * gpk_icon_loader_lookup:
+ *
+ * Returns: (transfer full): the cached icon, or %NULL if it was not loaded yet.
+ **/
+GdkPixbuf *
+gpk_icon_loader_lookup (GpkIconLoader *loader, const gchar *filename, gint size)
+{
+	GdkPixbuf *pixbuf;
+	gchar *key;
+
+	g_return_val_if_fail (GPK_IS_ICON_LOADER (loader), NULL);
+
+	key = gpk_icon_loader_get_key (filename, size);
+	pixbuf = gpk_icon_loader_cache_lookup (loader, key);
+	g_free (key);
+
+	return pixbuf;
+}
+
+GdkPixbuf *
+gpk_icon_loader_load_finish (GpkIconLoader  *loader,
+                             GAsyncResult   *result,
+                             GError        **error)
+{
+	g_return_val_if_fail (GPK_IS_ICON_LOADER (loader), NULL);
+
+	return g_task_propagate_pointer (G_TASK (result), error);
+}
+
+/**
+ * gpk_icon_loader_load_async:
+ * @id: (nullable): the component id, used to save the scaled icon on disk.
+ *
+ * Decode and scale the icon in the worker pool.
+ **/
+void
+gpk_icon_loader_load_async (GpkIconLoader       *loader,
+                            const gchar         *id,
+                            const gchar         *filename,
+                            gint                 size,
+                            GCancellable        *cancellable,
+                            GAsyncReadyCallback  callback,
+                            gpointer             user_data)
+{
+	GpkIconLoaderRequest *request;
+	GTask *task;
+
+	g_return_if_fail (GPK_IS_ICON_LOADER (loader));
+	g_return_if_fail (filename != NULL);
+
+	request = g_new0 (GpkIconLoaderRequest, 1);
+	request->id = g_strdup (id);
+	request->filename = g_strdup (filename);
+	request->size = size;
+
+	task = g_task_new (loader, cancellable, callback, user_data);
+	g_task_set_source_tag (task, gpk_icon_loader_load_async);
+	g_task_set_task_data (task, request, (GDestroyNotify) gpk_icon_loader_request_free);
+
+	g_thread_pool_push (loader->pool, task, NULL);
+}
+
+static void
+gpk_icon_loader_thumb_free (GpkIconLoaderThumb *thumb)
+{
+	g_free (thumb->filename);
+	g_free (thumb);
+}
+
+static gint
+gpk_icon_loader_thumb_cmp (gconstpointer a, gconstpointer b)
+{
+	const GpkIconLoaderThumb *thumb_a = *(const GpkIconLoaderThumb **) a;
+	const GpkIconLoaderThumb *thumb_b = *(const GpkIconLoaderThumb **) b;
+
+	if (thumb_a->mtime < thumb_b->mtime)
+		return -1;
+	if (thumb_a->mtime > thumb_b->mtime)
+		return 1;
+	return 0;
+}
+
+/**
+ * gpk_icon_loader_prune_thumbs:
+ *
+ * Remove the old thumbnails, and then the oldest ones while they use
+ * too much space. Those still used are just saved again.
+ **/
+static void
+gpk_icon_loader_prune_thumbs (GTask        *task,
+                              gpointer      source_object,
+                              gpointer      task_data,
+                              GCancellable *cancellable)
+{
+	GpkIconLoader *loader = GPK_ICON_LOADER (source_object);
+	GpkIconLoaderThumb *thumb;
+	GPtrArray *thumbs;
+	GDir *dir, *size_dir;
+	GStatBuf st;
+	const gchar *name, *thumb_name;
+	gchar *dirname, *filename;
+	gint64 now;
+	goffset total = 0;
+	guint i, pruned = 0;
+
+	dir = g_dir_open (loader->thumbs_dir, 0, NULL);
+	if (dir == NULL) {
+		g_task_return_boolean (task, TRUE);
+		return;
+	}
+
+	now = g_get_real_time () / G_USEC_PER_SEC;
+	thumbs = g_ptr_array_new_with_free_func ((GDestroyNotify) gpk_icon_loader_thumb_free);
+
+	while ((name = g_dir_read_name (dir)) != NULL) {
+		dirname = g_build_filename (loader->thumbs_dir, name, NULL);
+		size_dir = g_dir_open (dirname, 0, NULL);
+		if (size_dir == NULL) {
+			g_free (dirname);
+			continue;
+		}
+		while ((thumb_name = g_dir_read_name (size_dir)) != NULL) {
+			filename = g_build_filename (dirname, thumb_name, NULL);
+			if (g_stat (filename, &st) != 0) {
+				g_free (filename);
+				continue;
+			}
+			if (now - (gint64) st.st_mtime > GPK_ICON_LOADER_THUMB_MAX_AGE) {
+				if (g_unlink (filename) == 0)
+					pruned++;
+				g_free (filename);
+				continue;
+			}
+			thumb = g_new0 (GpkIconLoaderThumb, 1);
+			thumb->filename = filename;
+			thumb->mtime = (gint64) st.st_mtime;
+			thumb->size = (goffset) st.st_size;
+			g_ptr_array_add (thumbs, thumb);
+			total += thumb->size;
+		}
+		g_dir_close (size_dir);
+		g_free (dirname);
+	}
+	g_dir_close (dir);
+
+	/* the oldest first */
+	g_ptr_array_sort (thumbs, gpk_icon_loader_thumb_cmp);
+	for (i = 0; i < thumbs->len && total > GPK_ICON_LOADER_THUMB_MAX_SIZE; i++) {
+		thumb = g_ptr_array_index (thumbs, i);
+		if (g_unlink (thumb->filename) == 0) {
+			total -= thumb->size;
+			pruned++;
+		}
+	}
+
+	g_debug ("Pruned %u icon thumbnails", pruned);
+
+	g_ptr_array_unref (thumbs);
+	g_task_return_boolean (task, TRUE);
+}
+
+static void
+gpk_icon_loader_finalize (GObject *object)
+{
+	GpkIconLoader *loader;
+
+	g_return_if_fail (GPK_IS_ICON_LOADER (object));
+
+	loader = GPK_ICON_LOADER (object);
+
+	/* queued tasks keep a reference, so the pool is already empty */
+	g_thread_pool_free (loader->pool, FALSE, TRUE);
+
+	g_hash_table_unref (loader->cache);
+	g_queue_free_full (loader->cache_lru, (GDestroyNotify) gpk_icon_loader_entry_free);
+	g_mutex_clear (&loader->cache_lock);
+
+	g_free (loader->thumbs_dir);
+
+	G_OBJECT_CLASS (gpk_icon_loader_parent_class)->finalize (object);
+}
+
+static void
+gpk_icon_loader_init (GpkIconLoader *loader)
+{
+	loader->pool = g_thread_pool_new ((GFunc) gpk_icon_loader_worker,
+	                                  loader,
+	                                  (gint) MIN (g_get_num_processors (), GPK_ICON_LOADER_MAX_THREADS),
+	                                  FALSE,
+	                                  NULL);
+
+	loader->thumbs_dir = g_build_filename (g_get_user_cache_dir (),
+	                                       "xings-software",
+	                                       "icons",
+	                                       NULL);
+
+	g_mutex_init (&loader->cache_lock);
+	loader->cache_lru = g_queue_new ();
+	loader->cache = g_hash_table_new (g_str_hash, g_str_equal);
+}
+
+static void
+gpk_icon_loader_constructed (GObject *object)
+{
+	GTask *task;
+
+	G_OBJECT_CLASS (gpk_icon_loader_parent_class)->constructed (object);
+
+	/* keep the thumbnails on disk bounded */
+	task = g_task_new (object, NULL, NULL, NULL);
+	g_task_set_source_tag (task, gpk_icon_loader_prune_thumbs);
+	g_task_run_in_thread (task, gpk_icon_loader_prune_thumbs);
+	g_object_unref (task);
+}
+
+static void
+gpk_icon_loader_class_init (GpkIconLoaderClass *klass)
+{
+	GObjectClass *object_class = G_OBJECT_CLASS (klass);
+	object_class->constructed = gpk_icon_loader_constructed;
+	object_class->finalize = gpk_icon_loader_finalize;
+}
+
+GpkIconLoader *
+gpk_icon_loader_new (void)
+{
+	GpkIconLoader *loader;
+	loader = g_object_new (GPK_TYPE_ICON_LOADER, NULL);
+	return GPK_ICON_LOADER (loader);
+}
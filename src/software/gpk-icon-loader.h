@@ -0,0 +1,56 @@
+/* -*- Mode: C; tab-width: 8; indent-tabs-mode: t; c-basic-offset: 8 -*-
+ *
+ * Copyright (C) 2024 Matias De lellis <mati86dl@gmail.com>
+ *
+ * Licensed under the GNU General Public License Version 2
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef __GPK_ICON_LOADER_H
+#define __GPK_ICON_LOADER_H
+
+#include <glib-object.h>
+#include <gio/gio.h>
+#include <gdk-pixbuf/gdk-pixbuf.h>
+
+G_BEGIN_DECLS
+
+#define GPK_TYPE_ICON_LOADER (gpk_icon_loader_get_type())
+G_DECLARE_FINAL_TYPE (GpkIconLoader, gpk_icon_loader, GPK, ICON_LOADER, GObject)
+
+GdkPixbuf *
+gpk_icon_loader_lookup (GpkIconLoader *loader, const gchar *filename, gint size);
+
+GdkPixbuf *
+gpk_icon_loader_load_finish (GpkIconLoader  *loader,
+                             GAsyncResult   *result,
+                             GError        **error);
+
+void
+gpk_icon_loader_load_async (GpkIconLoader       *loader,
+                            const gchar         *id,
+                            const gchar         *filename,
+                            gint                 size,
+                            GCancellable        *cancellable,
+                            GAsyncReadyCallback  callback,
+                            gpointer             user_data);
+
+GpkIconLoader *
+gpk_icon_loader_new (void);
+
+G_END_DECLS
+
+#endif /* __GPK_ICON_LOADER_H */
@@ -21,14 +21,72 @@
 
 #include "config.h"
 
+#include <string.h>
 #include <glib.h>
 #include <gio/gio.h>
+#include <packagekit-glib2/packagekit.h>
 
 #include "gpk-packages-list.h"
 
-#define A_BEFORE_B -1
-#define A_WITH_B 0
-#define A_AFTER_B 1
+typedef enum {
+	GPK_PACKAGES_LIST_RANK_SPECIAL,
+	GPK_PACKAGES_LIST_RANK_SEPARATOR,
+	GPK_PACKAGES_LIST_RANK_CATEGORY,
+	GPK_PACKAGES_LIST_RANK_APPLICATION,
+	GPK_PACKAGES_LIST_RANK_PACKAGE
+} GpkPackagesListRank;
+
+/**
+ * gpk_packages_list_sort_key_new:
+ *
+ * First specials, then separator, categories, applications and at the
+ * end distribution packages, each one sorted by name.
+ *
+ * Returns: the key to set in PACKAGES_COLUMN_SORT_KEY
+ **/
+GBytes *
+gpk_packages_list_sort_key_new (gboolean     is_special,
+                                gboolean     is_separator,
+                                gboolean     is_category,
+                                const gchar *app_name,
+                                const gchar *package_id)
+{
+	GpkPackagesListRank rank;
+	const gchar *name = NULL;
+	gchar *casefold = NULL, *collate_key = NULL;
+	gchar *key = NULL;
+	gsize len = 0;
+
+	if (is_special) {
+		rank = GPK_PACKAGES_LIST_RANK_SPECIAL;
+		name = app_name;
+	} else if (is_separator) {
+		rank = GPK_PACKAGES_LIST_RANK_SEPARATOR;
+	} else if (is_category) {
+		rank = GPK_PACKAGES_LIST_RANK_CATEGORY;
+		name = app_name;
+	} else if (app_name != NULL) {
+		rank = GPK_PACKAGES_LIST_RANK_APPLICATION;
+		name = app_name;
+	} else {
+		rank = GPK_PACKAGES_LIST_RANK_PACKAGE;
+		name = package_id;
+	}
+
+	if (name != NULL) {
+		casefold = g_utf8_casefold (name, -1);
+		collate_key = g_utf8_collate_key (casefold, -1);
+	}
+
+	/* the rank goes first, so it wins over the name */
+	key = g_strdup_printf ("%c%s", '0' + rank, collate_key != NULL ? collate_key : "");
+	len = strlen (key);
+
+	g_free (casefold);
+	g_free (collate_key);
+
+	return g_bytes_new_take (key, len);
+}
 
 static gint
 gpk_packages_list_column_sort_func (GtkTreeModel *model,
@@ -36,64 +94,25 @@ gpk_packages_list_column_sort_func (GtkTreeModel *model,
                                     GtkTreeIter  *b,
                                     gpointer      user_data)
 {
-	gchar *app_name_a, *app_name_b;
-	gchar *package_id_a, *package_id_b;
-	gboolean is_special_a, is_special_b;
-	gboolean is_separator_a, is_separator_b;
-	gboolean is_category_a, is_category_b;
+	GBytes *key_a = NULL, *key_b = NULL;
 	gint result = 0;
 
-	gtk_tree_model_get (model, a,
-	                    PACKAGES_COLUMN_APP_NAME, &app_name_a,
-	                    PACKAGES_COLUMN_ID, &package_id_a,
-	                    PACKAGES_COLUMN_IS_SPECIAL, &is_special_a,
-	                    PACKAGES_COLUMN_IS_SEPARATOR, &is_separator_a,
-	                    PACKAGES_COLUMN_IS_CATEGORY, &is_category_a,
-	                    -1);
-	gtk_tree_model_get (model, b,
-	                    PACKAGES_COLUMN_APP_NAME, &app_name_b,
-	                    PACKAGES_COLUMN_ID, &package_id_b,
-	                    PACKAGES_COLUMN_IS_SPECIAL, &is_special_b,
-	                    PACKAGES_COLUMN_IS_SEPARATOR, &is_separator_b,
-	                    PACKAGES_COLUMN_IS_CATEGORY, &is_category_b,
-	                    -1);
-
-	// first specials
-	if (is_special_a && is_special_b) {
-		result = strcasecmp (app_name_a, app_name_b);
-	} else if (is_special_a) {
-		result = A_BEFORE_B;
-	} else if (is_special_b) {
-		result = A_AFTER_B;
-	// then separator
-	} else if (is_separator_a && is_separator_b) {
-		result = A_WITH_B;
-	} else if (is_separator_a && is_special_b) {
-		result = A_AFTER_B;
-	} else if (is_separator_a && is_category_b) {
-		result = A_BEFORE_B;
-	// then categories
-	} else if (is_category_a && is_category_b) {
-		result = strcasecmp (app_name_a, app_name_b);
-	} else if (is_category_a && is_special_b) {
-		result = A_AFTER_B;
-	} else if (is_category_a && is_separator_b) {
-		result = A_AFTER_B;
-	// then applications and distribution packages...
-	} else if (app_name_a && app_name_b) {
-		result = strcasecmp (app_name_a, app_name_b);
-	} else if (app_name_a && !app_name_b) {
-		result = A_BEFORE_B;
-	} else if (!app_name_a && app_name_b) {
-		result = A_AFTER_B;
-	} else {
-		result = strcasecmp (package_id_a, package_id_b);
+	/* copying the boxed keys is just a reference */
+	gtk_tree_model_get (model, a, PACKAGES_COLUMN_SORT_KEY, &key_a, -1);
+	gtk_tree_model_get (model, b, PACKAGES_COLUMN_SORT_KEY, &key_b, -1);
+
+	if (key_a != NULL && key_b != NULL) {
+		result = g_bytes_compare (key_a, key_b);
+	} else if (key_a != NULL) {
+		result = -1;
+	} else if (key_b != NULL) {
+		result = 1;
 	}
 
-	g_free (app_name_a);
-	g_free (app_name_b);
-	g_free (package_id_a);
-	g_free (package_id_b);
+	if (key_a != NULL)
+		g_bytes_unref (key_a);
+	if (key_b != NULL)
+		g_bytes_unref (key_b);
 
 	return result;
 }
@@ -119,7 +138,10 @@ gpk_packages_list_store_new (void)
 	                                          G_TYPE_STRING,
 	                                          G_TYPE_BOOLEAN,
 	                                          G_TYPE_BOOLEAN,
-	                                          G_TYPE_BOOLEAN);
+	                                          G_TYPE_BOOLEAN,
+	                                          PK_TYPE_PACKAGE,
+	                                          G_TYPE_BYTES,
+	                                          G_TYPE_STRING);
 
 	gtk_tree_sortable_set_sort_func (GTK_TREE_SORTABLE (store),
 	                                 PACKAGES_COLUMN_ID,
@@ -36,9 +36,19 @@ enum {
 	PACKAGES_COLUMN_IS_SPECIAL,
 	PACKAGES_COLUMN_IS_SEPARATOR,
 	PACKAGES_COLUMN_IS_CATEGORY,
+	PACKAGES_COLUMN_PACKAGE,
+	PACKAGES_COLUMN_SORT_KEY,
+	PACKAGES_COLUMN_PKGNAME,	/* of the rows only known by AppStream */
 	PACKAGES_COLUMN_LAST
 };
 
+GBytes *
+gpk_packages_list_sort_key_new (gboolean     is_special,
+                                gboolean     is_separator,
+                                gboolean     is_category,
+                                const gchar *app_name,
+                                const gchar *package_id);
+
 gboolean
 gpk_packages_list_row_separator_func (GtkTreeModel *model,
                                       GtkTreeIter  *iter,